@@ -0,0 +1,1109 @@
+	#include <pthread.h>
+    #include <stdbool.h>
+    #include <stdint.h>
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <time.h>
+    #include <sys/mman.h>
+
+    #include "../lnklst.h"
+
+//********************************************************************************************************
+// Local defines
+//********************************************************************************************************
+
+    //a benchmark, run when no names are given on the command line or its name starts with one of them
+    struct bench_struct
+    {
+        const char *name;
+        void (*func)(void);
+    };
+
+    //a list being written to, and scanned by another thread until stop is set
+    struct scan_bench_struct
+    {
+        struct lnklst_struct *list;
+        int stop;
+        long scans;
+    };
+
+    //the key to find at offset 8 and its length, for key_matches()
+    struct key_struct
+    {
+        const uint8_t *key;
+        size_t keylen;
+    };
+
+    //one producer/consumer configuration of the blocking queue
+    struct queue_bench_struct
+    {
+        struct lnklst_struct *queue;
+        long items;             //per producer
+        int batch;
+        int64_t *latencies;     //ns from push to pop, one per item
+        long taken;             //advanced with atomics by the consumers
+    };
+
+    LNKLST_DEFINE_TYPED(ints, int, (*a > *b) - (*a < *b))
+
+    //the widest vector of floats the build can load with one instruction
+    #ifdef __AVX__
+    #define VECTOR_FLOATS   8
+    #else
+    #define VECTOR_FLOATS   4
+    #endif
+    typedef float vector __attribute__((vector_size(VECTOR_FLOATS * sizeof(float))));
+
+//********************************************************************************************************
+// Private prototypes
+//********************************************************************************************************
+
+    static void bench_queue(void);
+    static void bench_index(void);
+    static void bench_compact(void);
+    static void bench_prefetch(void);
+    static void bench_save(void);
+    static void bench_allocator(void);
+    static void bench_typed(void);
+    static void bench_aligned(void);
+    static void bench_arena(void);
+    static void bench_parallel(void);
+    static void bench_pool(void);
+    static void bench_find(void);
+    static void bench_merge(void);
+    static void bench_top_k(void);
+    static void bench_resort(void);
+    #ifdef LNKLST_EPOCH
+    static void bench_snapshot(void);
+    static void* snapshot_scanner(void *arg);
+    static void* locked_scanner(void *arg);
+    static bool scan_work(void *allocation, void *ctx);
+    static void snapshot_run(const char *name, void*(*scanner)(void*));
+    #endif
+
+    static int64_t now_ns(void);
+    static void report(const char *name, int64_t ns, long ops);
+    static int compare_int64(const void *a, const void *b);
+    static void* queue_producer(void *arg);
+    static void* queue_consumer(void *arg);
+    static void queue_run(int producers, int consumers, int batch);
+    static struct lnklst_struct* int_list(int count);
+    static struct lnklst_struct* random_list(int count);
+    static struct lnklst_struct* scattered_list(int count);
+    static int compare_int(void *a, void *b);
+    static int compare_int_descending(void *a, void *b);
+    static int compare_int_qsort(const void *a, const void *b);
+    static bool never(void *allocation, void *ctx);
+    static void walk(const char *name, struct lnklst_struct *list);
+    static bool file_write(const void *src, size_t len, void *ctx);
+    static bool file_read(void *dst, size_t len, void *ctx);
+    static void aligned_run(const char *name, size_t alignment, size_t offset, bool aligned_loads);
+    static inline vector vector_load(const float *f);
+    static void arena_run(const char *name, const struct lnklst_allocator *allocator);
+    static void mix(void *allocation, void *ctx);
+    static void sum_int(void *acc, void *allocation);
+    static void sum_long(void *acc, void *other);
+    static void skewed(void *allocation, void *ctx);
+    static bool key_matches(void *allocation, void *ctx);
+    static void find_run(struct lnklst_struct *list, size_t keylen);
+    static void merge_run(int count);
+    static int compare_equal(void *a, void *b);
+    static void top_k_run(int k);
+    static void allocator_run(const char *name, const struct lnklst_allocator *allocator);
+    static void* wrapped_alloc(size_t size, void *ctx);
+    static void* wrapped_realloc(void *ptr, size_t size, void *ctx);
+    static void wrapped_free(void *ptr, void *ctx);
+
+    static const struct bench_struct benches[] =
+    {
+        {"queue", bench_queue},
+        {"index", bench_index},
+        {"compact", bench_compact},
+        {"prefetch", bench_prefetch},
+        {"save", bench_save},
+        {"allocator", bench_allocator},
+        {"typed", bench_typed},
+        {"aligned", bench_aligned},
+        {"arena", bench_arena},
+        {"parallel", bench_parallel},
+        {"pool", bench_pool},
+        {"find", bench_find},
+        {"merge", bench_merge},
+        {"topk", bench_top_k},
+        {"resort", bench_resort},
+        #ifdef LNKLST_EPOCH
+        {"snapshot", bench_snapshot},
+        #endif
+    };
+
+//********************************************************************************************************
+// Public functions
+//********************************************************************************************************
+
+int main(int argc, const char* argv[])
+{
+    size_t i;
+    int j;
+
+    for(i = 0; i < sizeof(benches) / sizeof(benches[0]); i++)
+    {
+        for(j = 1; j < argc && strncmp(benches[i].name, argv[j], strlen(argv[j])); j++)
+            ;
+        if(argc == 1 || j < argc)
+        {
+            printf("\n%s\n", benches[i].name);
+            benches[i].func();
+        };
+    };
+
+    return 0;
+}
+
+//********************************************************************************************************
+// Private functions
+//********************************************************************************************************
+
+// throughput and push to pop latency of the blocking queue, at N:1 and 1:N producers to consumers, one at a time and in batches
+static void bench_queue(void)
+{
+    queue_run(1, 1, 1);
+    queue_run(4, 1, 1);
+    queue_run(1, 4, 1);
+    queue_run(1, 1, 32);
+    queue_run(4, 1, 32);
+    queue_run(1, 4, 32);
+}
+
+// lnklst_index() walked sequentially, in reverse and at random, against following the links with lnklst_after()
+static void bench_index(void)
+{
+    struct lnklst_struct *list = int_list(100000);
+    volatile long sum = 0;
+    int64_t start;
+    void *x;
+    int i;
+
+    start = now_ns();
+    for(x = lnklst_first(list); x; x = lnklst_after(list, x))
+        sum += *(int*)x;
+    report("lnklst_after() walk", now_ns() - start, 100000);
+
+    start = now_ns();
+    for(i = 0; i < 100000; i++)
+        sum += *(int*)lnklst_index(list, i);
+    report("lnklst_index() sequential", now_ns() - start, 100000);
+
+    start = now_ns();
+    for(i = 100000 - 1; i >= 0; i--)
+        sum += *(int*)lnklst_index(list, i);
+    report("lnklst_index() reverse", now_ns() - start, 100000);
+
+    //random indices walk on average a quarter of the list from the nearest end or the finger
+    srand(1);
+    start = now_ns();
+    for(i = 0; i < 2000; i++)
+        sum += *(int*)lnklst_index(list, rand() % 100000);
+    report("lnklst_index() random", now_ns() - start, 2000);
+
+    lnklst_destroy(&list);
+}
+
+// walking a 1M node list whose order has been shuffled through the heap, before and after lnklst_compact()
+static void bench_compact(void)
+{
+    struct lnklst_struct *list = scattered_list(1000000);
+    int64_t start;
+
+    walk("scattered", list);
+    start = now_ns();
+    lnklst_compact(list, NULL, NULL);
+    report("lnklst_compact()", now_ns() - start, 1000000);
+    walk("compacted", list);
+    lnklst_destroy(&list);
+}
+
+// pointer chases through a scattered list far larger than the last level cache, to compare with the LNKLST_PREFETCH builds
+static void bench_prefetch(void)
+{
+    struct lnklst_struct *list = scattered_list(8000000);
+    int64_t start;
+
+    walk("8M scattered", list);
+
+    start = now_ns();
+    lnklst_index(list, 8000000 / 2);
+    report("lnklst_index() to the middle", now_ns() - start, 8000000 / 2);
+
+    //sorting again with a new comparator sorts the whole list
+    start = now_ns();
+    lnklst_sort(list, compare_int_descending);
+    report("lnklst_sort()", now_ns() - start, 8000000);
+
+    start = now_ns();
+    lnklst_destroy(&list);
+    report("lnklst_destroy()", now_ns() - start, 8000000);
+}
+
+// restarting from a 2M node file: reading the values back one at a time into new allocations, lnklst_load(), and walking it mapped with lnklst_map()
+// the file is written once and read back from the page cache, so this measures the rebuild rather than the disk
+static void bench_save(void)
+{
+    const char *path = "bench_save.tmp";
+    struct lnklst_struct *list = int_list(2000000);
+    struct lnklst_struct *copy;
+    const struct lnklst_map_struct *map;
+    volatile long sum = 0;
+    const void *y;
+    int64_t start;
+    FILE *file;
+    void *image;
+    size_t length;
+    int value;
+    void *x;
+
+    file = fopen(path, "wb");
+    for(x = lnklst_first(list); x; x = lnklst_after(list, x))
+        fwrite(x, sizeof(int), 1, file);
+    fclose(file);
+    lnklst_destroy(&list);
+
+    start = now_ns();
+    file = fopen(path, "rb");
+    list = lnklst_create();
+    while(fread(&value, sizeof(int), 1, file) == 1)
+        *(int*)lnklst_allocate(list, sizeof(int)) = value;
+    fclose(file);
+    report("per value rebuild", now_ns() - start, 2000000);
+
+    file = fopen(path, "wb");
+    lnklst_save(list, false, file_write, file);
+    fclose(file);
+
+    start = now_ns();
+    file = fopen(path, "rb");
+    copy = lnklst_load(file_read, file);
+    fclose(file);
+    report("lnklst_load()", now_ns() - start, lnklst_count(copy));
+    lnklst_destroy(&copy);
+
+    file = fopen(path, "wb");
+    lnklst_save(list, true, file_write, file);
+    fclose(file);
+    lnklst_destroy(&list);
+
+    start = now_ns();
+    file = fopen(path, "rb");
+    list = lnklst_load(file_read, file);
+    fclose(file);
+    report("lnklst_load(), checksummed", now_ns() - start, lnklst_count(list));
+    lnklst_destroy(&list);
+
+    //mapping validates the whole image, then walking it touches only the pages it reaches
+    start = now_ns();
+    file = fopen(path, "rb");
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    image = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    map = lnklst_map(image, length);
+    report("lnklst_map(), checksummed", now_ns() - start, lnklst_map_count(map));
+    start = now_ns();
+    for(y = lnklst_map_first(map); y; y = lnklst_map_after(map, y))
+        sum += *(const int*)y;
+    report("lnklst_map_after() walk", now_ns() - start, lnklst_map_count(map));
+    munmap(image, length);
+    fclose(file);
+
+    remove(path);
+}
+
+// the same list work through the lnklst_platform_ macros, through an allocator which calls the same malloc() indirectly, and from an arena
+static void bench_allocator(void)
+{
+    const struct lnklst_allocator wrapped = {wrapped_alloc, wrapped_realloc, wrapped_free, NULL};
+    struct lnklst_arena_struct *arena = lnklst_arena_create(1 << 20);
+
+    //the first list faults in the heap which the others reuse, so it is run once first and not counted
+    allocator_run("", NULL);
+    allocator_run("lnklst_platform_alloc()", NULL);
+    allocator_run("malloc() through an allocator", &wrapped);
+    allocator_run("arena", lnklst_arena_allocator(arena));
+    lnklst_arena_destroy(&arena);
+}
+
+// sorting 1M random ints with lnklst_sort() calling the comparator through a pointer, with the inlined comparison of LNKLST_DEFINE_TYPED(),
+// and with qsort() over a plain array of the same ints, as the floor for a list which has to chase its links
+static void bench_typed(void)
+{
+    //both lists are built before either is sorted, as one built from the blocks freed by the other would be scattered through the heap
+    struct lnklst_struct *list = random_list(1000000);
+    struct lnklst_struct *typed = random_list(1000000);
+    int *array = malloc(1000000 * sizeof(int));
+    int64_t start;
+    int i;
+
+    start = now_ns();
+    lnklst_sort(list, compare_int);
+    report("lnklst_sort()", now_ns() - start, 1000000);
+    lnklst_destroy(&list);
+
+    start = now_ns();
+    ints_sort(typed);
+    report("LNKLST_DEFINE_TYPED() sort", now_ns() - start, 1000000);
+    lnklst_destroy(&typed);
+
+    srand(1);
+    for(i = 0; i < 1000000; i++)
+        array[i] = rand();
+    start = now_ns();
+    qsort(array, 1000000, sizeof(int), compare_int_qsort);
+    report("qsort() of an array", now_ns() - start, 1000000);
+    free(array);
+}
+
+// summing the floats in 64 allocations of 4KB, timed per allocation summed, small enough to stay in the cache so that the loads rather than memory set the pace
+// aligned to a cache line, aligned only to LNKLST_PLATFORM_ALIGN, and misaligned by 4 bytes so that some loads split a cache line
+static void bench_aligned(void)
+{
+    aligned_run("64 byte aligned, aligned loads", 64, 0, true);
+    aligned_run("64 byte aligned, unaligned loads", 64, 0, false);
+    aligned_run("LNKLST_PLATFORM_ALIGN, unaligned loads", LNKLST_PLATFORM_ALIGN, 0, false);
+    aligned_run("4 bytes off, unaligned loads", 64, 4, false);
+}
+
+// a scattered 4M node list allocated with malloc() and from an arena of 64MB chunks, to compare with the LNKLST_HUGEPAGES and LNKLST_NUMA builds
+// following links at random through a few hundred MB misses the TLB on most steps with 4KB pages, but far less often with 2MB ones
+static void bench_arena(void)
+{
+    struct lnklst_arena_struct *arena = lnklst_arena_create(64 << 20);
+
+    arena_run("malloc()", NULL);
+    arena_run("arena", lnklst_arena_allocator(arena));
+    lnklst_arena_destroy(&arena);
+}
+
+// lnklst_parallel_foreach() with some arithmetic per allocation, and lnklst_parallel_reduce() summing, over 1M ints at 1 to 32 threads
+// against a plain lnklst_after() walk doing the same on the calling thread
+static void bench_parallel(void)
+{
+    static const int threads[] = {1, 2, 4, 8, 16, 32};
+    struct lnklst_struct *list = int_list(1000000);
+    const long zero = 0;
+    char line[64];
+    int64_t start;
+    long total;
+    size_t i;
+    void *x;
+
+    start = now_ns();
+    for(x = lnklst_first(list); x; x = lnklst_after(list, x))
+        mix(x, NULL);
+    report("foreach, lnklst_after() walk", now_ns() - start, 1000000);
+    for(i = 0; i < sizeof(threads) / sizeof(threads[0]); i++)
+    {
+        start = now_ns();
+        lnklst_parallel_foreach(list, mix, NULL, threads[i]);
+        snprintf(line, sizeof(line), "lnklst_parallel_foreach(), %d threads", threads[i]);
+        report(line, now_ns() - start, 1000000);
+    };
+
+    start = now_ns();
+    total = 0;
+    for(x = lnklst_first(list); x; x = lnklst_after(list, x))
+        sum_int(&total, x);
+    report("reduce, lnklst_after() walk", now_ns() - start, 1000000);
+    for(i = 0; i < sizeof(threads) / sizeof(threads[0]); i++)
+    {
+        start = now_ns();
+        lnklst_parallel_reduce(list, sum_int, sum_long, &zero, &total, sizeof(total), threads[i]);
+        snprintf(line, sizeof(line), "lnklst_parallel_reduce(), %d threads", threads[i]);
+        report(line, now_ns() - start, 1000000);
+    };
+
+    lnklst_destroy(&list);
+}
+
+// skewed work over 1M ints, where the first eighth of the list costs 64 times as much per allocation as the rest
+// split statically into one segment per thread by lnklst_parallel_foreach(), and into several per thread, stolen when idle, by a pool
+static void bench_pool(void)
+{
+    static const int threads[] = {1, 4, 8};
+    struct lnklst_struct *list = int_list(1000000);
+    struct lnklst_pool_struct *pool;
+    char line[64];
+    int64_t start;
+    size_t i;
+
+    for(i = 0; i < sizeof(threads) / sizeof(threads[0]); i++)
+    {
+        start = now_ns();
+        lnklst_parallel_foreach(list, skewed, NULL, threads[i]);
+        snprintf(line, sizeof(line), "lnklst_parallel_foreach(), %d threads", threads[i]);
+        report(line, now_ns() - start, 1000000);
+
+        //the calling thread works too, so the pool has one fewer
+        pool = lnklst_pool_create(threads[i] - 1);
+        start = now_ns();
+        lnklst_pool_foreach(pool, list, skewed, NULL);
+        snprintf(line, sizeof(line), "lnklst_pool_foreach(), %d threads", threads[i]);
+        report(line, now_ns() - start, 1000000);
+        lnklst_pool_destroy(&pool);
+    };
+
+    lnklst_destroy(&list);
+}
+
+// finding the last of 1M 32 byte records by a key at offset 8, so that every search scans the whole list
+// with lnklst_find_bytes(), with lnklst_find() and a memcmp() predicate, and with a lnklst_after() walk calling memcmp()
+static void bench_find(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    uint8_t *record;
+    int i;
+
+    for(i = 0; i < 1000000; i++)
+    {
+        record = lnklst_allocate(list, 32);
+        memset(record, 0, 32);
+        memcpy(&record[8], &i, sizeof(i));
+        memcpy(&record[20], &i, sizeof(i));
+    };
+
+    find_run(list, 4);
+    find_run(list, 16);
+    lnklst_destroy(&list);
+}
+
+// merging 2M random ints from 2 and from 16 sorted lists, against concatenating the lists and sorting the result
+static void bench_merge(void)
+{
+    merge_run(2);
+    merge_run(16);
+}
+
+// the smallest 100 and 10000 of 2M random ints, with lnklst_top_k() and lnklst_partial_sort(), against sorting the whole list
+static void bench_top_k(void)
+{
+    top_k_run(100);
+    top_k_run(10000);
+}
+
+// re-sorting a sorted list of 1M random ints after appending 1000 and 100000 more, sorting only the new tail and merging it in,
+// against sorting the whole of an identical list marked unsorted with lnklst_mark_unsorted()
+static void bench_resort(void)
+{
+    static const int appended[] = {1000, 100000};
+    struct lnklst_struct *tail;
+    struct lnklst_struct *full;
+    char line[64];
+    int64_t start;
+    size_t i;
+    int j;
+
+    for(i = 0; i < sizeof(appended) / sizeof(appended[0]); i++)
+    {
+        //built side by side, so that their nodes are equally spread through the heap
+        tail = lnklst_create();
+        full = lnklst_create();
+        srand(1);
+        for(j = 0; j < 1000000 + appended[i]; j++)
+        {
+            if(j == 1000000)
+            {
+                lnklst_sort(tail, compare_int);
+                lnklst_sort(full, compare_int);
+            };
+            *(int*)lnklst_allocate(tail, sizeof(int)) = rand();
+            *(int*)lnklst_allocate(full, sizeof(int)) = *(int*)lnklst_last(tail);
+        };
+
+        start = now_ns();
+        lnklst_sort(tail, compare_int);
+        snprintf(line, sizeof(line), "%d appended, lnklst_sort() of the tail", appended[i]);
+        report(line, now_ns() - start, 1000000 + appended[i]);
+
+        lnklst_mark_unsorted(full);
+        start = now_ns();
+        lnklst_sort(full, compare_int);
+        snprintf(line, sizeof(line), "%d appended, lnklst_sort() of it all", appended[i]);
+        report(line, now_ns() - start, 1000000 + appended[i]);
+
+        lnklst_destroy(&tail);
+        lnklst_destroy(&full);
+    };
+}
+
+#ifdef LNKLST_EPOCH
+
+// latency of a writer pushing and freeing for a second while another thread scans the list, under its lock or through snapshots
+// each scan does some work per allocation, as a report would, so that scanning takes longer than capturing a snapshot
+static void bench_snapshot(void)
+{
+    snapshot_run("no scan", NULL);
+    snapshot_run("locked lnklst_find() scans", locked_scanner);
+    snapshot_run("lnklst_snapshot() scans", snapshot_scanner);
+}
+
+static void* snapshot_scanner(void *arg)
+{
+    struct scan_bench_struct *scan = arg;
+    struct lnklst_snapshot_struct *snap;
+    volatile long sum = 0;
+    int i;
+
+    while(!__atomic_load_n(&scan->stop, __ATOMIC_ACQUIRE))
+    {
+        snap = lnklst_snapshot(scan->list);
+        for(i = 0; i < lnklst_snapshot_count(snap); i++)
+            sum += scan_work(lnklst_snapshot_index(snap, i), NULL);
+        lnklst_snapshot_release(&snap);
+        scan->scans++;
+    };
+    return NULL;
+}
+
+static void* locked_scanner(void *arg)
+{
+    struct scan_bench_struct *scan = arg;
+
+    while(!__atomic_load_n(&scan->stop, __ATOMIC_ACQUIRE))
+    {
+        lnklst_find(scan->list, scan_work, NULL);
+        scan->scans++;
+    };
+    return NULL;
+}
+
+//some arithmetic on an allocation, never matching
+static bool scan_work(void *allocation, void *ctx)
+{
+    uint32_t x = *(int*)allocation;
+    int i;
+
+    (void)ctx;
+    for(i = 0; i < 16; i++)
+        x = x * 2654435761u + 1;
+    return x == 0 && i == 0;
+}
+
+static void snapshot_run(const char *name, void*(*scanner)(void*))
+{
+    struct scan_bench_struct scan = {int_list(1000000), 0, 0};
+    int64_t *latencies = malloc(10000000 * sizeof(int64_t));
+    int64_t end;
+    int64_t start;
+    pthread_t thread;
+    long n;
+
+    if(scanner)
+        pthread_create(&thread, NULL, scanner, &scan);
+    end = now_ns() + 1000000000;
+    for(n = 0, start = now_ns(); start < end && n < 10000000; n++)
+    {
+        *(int*)lnklst_push_back(scan.list, NULL, sizeof(int)) = n;
+        lnklst_free(scan.list, lnklst_first(scan.list));
+        latencies[n] = now_ns() - start;
+        start += latencies[n];
+    };
+    __atomic_store_n(&scan.stop, 1, __ATOMIC_RELEASE);
+    if(scanner)
+        pthread_join(thread, NULL);
+
+    qsort(latencies, n, sizeof(int64_t), compare_int64);
+    printf("  %-48s %10.1f us p50, %.1f us p99.9, %.1f us max (%ld writes, %ld scans of 1M)\n", name,
+        latencies[n / 2] / 1e3, latencies[n * 999 / 1000] / 1e3, latencies[n - 1] / 1e3, n, scan.scans);
+    free(latencies);
+    lnklst_destroy(&scan.list);
+}
+
+#endif
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void report(const char *name, int64_t ns, long ops)
+{
+    printf("  %-48s %10.1f ns/op  (%ld ops, %.3f s)\n", name, (double)ns / ops, ops, ns / 1e9);
+}
+
+static int compare_int64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+//push timestamps, a batch at a time
+static void* queue_producer(void *arg)
+{
+    struct queue_bench_struct *q = arg;
+    int64_t stamps[64];
+    long i;
+    int j;
+
+    for(i = 0; i < q->items; i += q->batch)
+    {
+        for(j = 0; j < q->batch; j++)
+            stamps[j] = now_ns();
+        lnklst_push_wait_many(q->queue, stamps, sizeof(int64_t), q->batch, -1);
+    };
+    return NULL;
+}
+
+//pop timestamps until the queue is closed and drained, recording how long each waited
+static void* queue_consumer(void *arg)
+{
+    struct queue_bench_struct *q = arg;
+    int64_t stamps[64];
+    int64_t now;
+    int n, j;
+
+    while((n = lnklst_pop_wait_many(q->queue, stamps, sizeof(int64_t), q->batch, -1)))
+    {
+        now = now_ns();
+        for(j = 0; j < n; j++)
+            q->latencies[__atomic_fetch_add(&q->taken, 1, __ATOMIC_RELAXED)] = now - stamps[j];
+    };
+    return NULL;
+}
+
+static void queue_run(int producers, int consumers, int batch)
+{
+    struct queue_bench_struct q;
+    pthread_t threads[8];
+    char name[64];
+    int64_t start;
+    int64_t elapsed;
+    long total;
+    int i;
+
+    q.queue = lnklst_create();
+    q.items = (200000 / producers / batch) * batch;
+    q.batch = batch;
+    q.taken = 0;
+    total = q.items * producers;
+    q.latencies = malloc(total * sizeof(int64_t));
+    lnklst_set_capacity(q.queue, 1024);
+
+    start = now_ns();
+    for(i = 0; i < consumers; i++)
+        pthread_create(&threads[producers + i], NULL, queue_consumer, &q);
+    for(i = 0; i < producers; i++)
+        pthread_create(&threads[i], NULL, queue_producer, &q);
+    for(i = 0; i < producers; i++)
+        pthread_join(threads[i], NULL);
+    lnklst_close(q.queue);
+    for(i = 0; i < consumers; i++)
+        pthread_join(threads[producers + i], NULL);
+    elapsed = now_ns() - start;
+
+    snprintf(name, sizeof(name), "%d:%d producers:consumers, batch %d", producers, consumers, batch);
+    report(name, elapsed, total);
+    qsort(q.latencies, total, sizeof(int64_t), compare_int64);
+    printf("  %-48s %10.1f us p50, %.1f us p99\n", "", q.latencies[total / 2] / 1e3, q.latencies[total * 99 / 100] / 1e3);
+
+    free(q.latencies);
+    lnklst_destroy(&q.queue);
+}
+
+//a list of count ints, 0 to count - 1
+static struct lnklst_struct* int_list(int count)
+{
+    struct lnklst_struct *retval = lnklst_create();
+    int i;
+
+    for(i = 0; i < count; i++)
+        *(int*)lnklst_allocate(retval, sizeof(int)) = i;
+
+    return retval;
+}
+
+//a list of count random ints, in the order they were allocated
+static struct lnklst_struct* random_list(int count)
+{
+    struct lnklst_struct *retval = lnklst_create();
+    int i;
+
+    srand(1);
+    for(i = 0; i < count; i++)
+        *(int*)lnklst_allocate(retval, sizeof(int)) = rand();
+
+    return retval;
+}
+
+//a list of count random ints, sorted so that following the links jumps about the heap rather than stepping through it
+static struct lnklst_struct* scattered_list(int count)
+{
+    struct lnklst_struct *retval = random_list(count);
+
+    lnklst_sort(retval, compare_int);
+
+    return retval;
+}
+
+static int compare_int(void *a, void *b)
+{
+    return (*(int*)a > *(int*)b) - (*(int*)a < *(int*)b);
+}
+
+static int compare_int_descending(void *a, void *b)
+{
+    return compare_int(b, a);
+}
+
+static int compare_int_qsort(const void *a, const void *b)
+{
+    return (*(const int*)a > *(const int*)b) - (*(const int*)a < *(const int*)b);
+}
+
+static bool never(void *allocation, void *ctx)
+{
+    (void)allocation;
+    (void)ctx;
+    return false;
+}
+
+//time a walk of the list with lnklst_after(), and a scan of it under one lock with lnklst_find()
+static void walk(const char *name, struct lnklst_struct *list)
+{
+    char line[64];
+    volatile long sum = 0;
+    int64_t start;
+    void *x;
+    int count = lnklst_count(list);
+
+    start = now_ns();
+    for(x = lnklst_first(list); x; x = lnklst_after(list, x))
+        sum += *(int*)x;
+    snprintf(line, sizeof(line), "%s, lnklst_after() walk", name);
+    report(line, now_ns() - start, count);
+
+    start = now_ns();
+    lnklst_find(list, never, NULL);
+    snprintf(line, sizeof(line), "%s, lnklst_find() scan", name);
+    report(line, now_ns() - start, count);
+}
+
+static bool file_write(const void *src, size_t len, void *ctx)
+{
+    return fwrite(src, 1, len, ctx) == len;
+}
+
+static bool file_read(void *dst, size_t len, void *ctx)
+{
+    return fread(dst, 1, len, ctx) == len;
+}
+
+//push 1M, then 1M of pushing one and freeing another, then destroy. Nothing is reported for an empty name
+static void allocator_run(const char *name, const struct lnklst_allocator *allocator)
+{
+    struct lnklst_struct *list = lnklst_create_with_allocator(allocator);
+    char line[64];
+    int64_t start;
+    int i;
+
+    start = now_ns();
+    for(i = 0; i < 1000000; i++)
+        *(int*)lnklst_push_back(list, NULL, sizeof(int)) = i;
+    snprintf(line, sizeof(line), "%s, push", name);
+    if(*name)
+        report(line, now_ns() - start, 1000000);
+
+    start = now_ns();
+    for(i = 0; i < 1000000; i++)
+    {
+        *(int*)lnklst_push_back(list, NULL, sizeof(int)) = i;
+        lnklst_free(list, lnklst_first(list));
+    };
+    snprintf(line, sizeof(line), "%s, push and free", name);
+    if(*name)
+        report(line, now_ns() - start, 1000000);
+
+    start = now_ns();
+    lnklst_destroy(&list);
+    snprintf(line, sizeof(line), "%s, destroy", name);
+    if(*name)
+        report(line, now_ns() - start, 1000000);
+}
+
+static void* wrapped_alloc(size_t size, void *ctx)
+{
+    (void)ctx;
+    return malloc(size);
+}
+
+static void* wrapped_realloc(void *ptr, size_t size, void *ctx)
+{
+    (void)ctx;
+    return realloc(ptr, size);
+}
+
+static void wrapped_free(void *ptr, void *ctx)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+//the sum of every allocation 20000 times, read with vector loads at offset bytes into allocations aligned to alignment
+//four sums are kept, so that the loads rather than the latency of the adds set the pace. Aligned loads fault unless the address is aligned
+static void aligned_run(const char *name, size_t alignment, size_t offset, bool aligned_loads)
+{
+    struct lnklst_struct *list = lnklst_create();
+    vector a = {0}, b = {0}, c = {0}, d = {0};
+    volatile float total;
+    int64_t start;
+    float *f;
+    void *x;
+    int i, j;
+
+    for(i = 0; i < 64; i++)
+    {
+        f = (float*)((char*)lnklst_allocate_aligned(list, 4096 + offset, alignment) + offset);
+        for(j = 0; j < 1024; j++)
+            f[j] = j;
+    };
+
+    start = now_ns();
+    for(i = 0; i < 20000; i++)
+    {
+        for(x = lnklst_first(list); x; x = lnklst_after(list, x))
+        {
+            f = (float*)((char*)x + offset);
+            if(aligned_loads)
+            {
+                for(j = 0; j < 1024; j += 4 * VECTOR_FLOATS)
+                {
+                    a += *(vector*)&f[j];
+                    b += *(vector*)&f[j + VECTOR_FLOATS];
+                    c += *(vector*)&f[j + 2 * VECTOR_FLOATS];
+                    d += *(vector*)&f[j + 3 * VECTOR_FLOATS];
+                };
+            }
+            else
+            {
+                for(j = 0; j < 1024; j += 4 * VECTOR_FLOATS)
+                {
+                    a += vector_load(&f[j]);
+                    b += vector_load(&f[j + VECTOR_FLOATS]);
+                    c += vector_load(&f[j + 2 * VECTOR_FLOATS]);
+                    d += vector_load(&f[j + 3 * VECTOR_FLOATS]);
+                };
+            };
+        };
+    };
+    total = a[0] + b[0] + c[0] + d[0];
+    (void)total;
+    report(name, now_ns() - start, 20000L * 64);
+    lnklst_destroy(&list);
+}
+
+//an unaligned load, which memcpy() becomes
+static inline vector vector_load(const float *f)
+{
+    vector retval;
+
+    memcpy(&retval, f, sizeof(retval));
+    return retval;
+}
+
+//build a 4M node list of random ints with the allocator, sort it so that its links jump about, walk it and destroy it
+static void arena_run(const char *name, const struct lnklst_allocator *allocator)
+{
+    struct lnklst_struct *list = lnklst_create_with_allocator(allocator);
+    char line[64];
+    int64_t start;
+    int i;
+
+    srand(1);
+    start = now_ns();
+    for(i = 0; i < 4000000; i++)
+        *(int*)lnklst_allocate(list, sizeof(int)) = rand();
+    snprintf(line, sizeof(line), "%s, allocate", name);
+    report(line, now_ns() - start, 4000000);
+    lnklst_sort(list, compare_int);
+
+    walk(name, list);
+
+    start = now_ns();
+    lnklst_destroy(&list);
+    snprintf(line, sizeof(line), "%s, destroy", name);
+    report(line, now_ns() - start, 4000000);
+}
+
+//replace an int with a hash of it
+static void mix(void *allocation, void *ctx)
+{
+    uint32_t x = *(int*)allocation;
+    int i;
+
+    (void)ctx;
+    for(i = 0; i < 64; i++)
+        x = x * 2654435761u + 1;
+    *(int*)allocation = x;
+}
+
+static void sum_int(void *acc, void *allocation)
+{
+    *(long*)acc += *(int*)allocation;
+}
+
+static void sum_long(void *acc, void *other)
+{
+    *(long*)acc += *(long*)other;
+}
+
+//hash an element of int_list(1000000) into its top byte, leaving its index in the rest, 64 times over for the first eighth of the list
+static void skewed(void *allocation, void *ctx)
+{
+    uint32_t index = *(uint32_t*)allocation & 0xFFFFFF;
+    uint32_t x = index;
+    int i;
+
+    (void)ctx;
+    for(i = index < 1000000 / 8 ? 0 : 63 * 64; i < 64 * 64; i++)
+        x = x * 2654435761u + 1;
+    *(uint32_t*)allocation = index | (x << 24);
+}
+
+static bool key_matches(void *allocation, void *ctx)
+{
+    struct key_struct *key = ctx;
+
+    return !memcmp((uint8_t*)allocation + 8, key->key, key->keylen);
+}
+
+//20 searches for the key of the last record, its keylen bytes at offset 8, each way
+static void find_run(struct lnklst_struct *list, size_t keylen)
+{
+    uint8_t *last = lnklst_last(list);
+    struct key_struct key = {last + 8, keylen};
+    volatile void *found = NULL;
+    char line[64];
+    int64_t start;
+    void *x;
+    int i;
+
+    start = now_ns();
+    for(i = 0; i < 20; i++)
+        found = lnklst_find_bytes(list, 8, key.key, keylen);
+    snprintf(line, sizeof(line), "%zu byte key, lnklst_find_bytes()", keylen);
+    report(line, now_ns() - start, 20L * 1000000);
+
+    start = now_ns();
+    for(i = 0; i < 20; i++)
+        found = lnklst_find(list, key_matches, &key);
+    snprintf(line, sizeof(line), "%zu byte key, lnklst_find() and memcmp()", keylen);
+    report(line, now_ns() - start, 20L * 1000000);
+
+    start = now_ns();
+    for(i = 0; i < 20; i++)
+    {
+        for(x = lnklst_first(list); x && !key_matches(x, &key); x = lnklst_after(list, x))
+            ;
+        found = x;
+    };
+    snprintf(line, sizeof(line), "%zu byte key, lnklst_after() and memcmp()", keylen);
+    report(line, now_ns() - start, 20L * 1000000);
+    (void)found;
+}
+
+//count sorted lists of 2M / count random ints merged with lnklst_merge_sorted() or lnklst_merge_sorted_many(), and a copy of them concatenated and sorted
+//the two sets are built side by side and re-linked rather than copied, so that both sort nodes equally scattered through the heap
+static void merge_run(int count)
+{
+    struct lnklst_struct *lists[16];
+    struct lnklst_struct *copies[16];
+    struct lnklst_struct *dst = lnklst_create();
+    char line[64];
+    int64_t start;
+    int i, j;
+
+    srand(1);
+    for(i = 0; i < count; i++)
+    {
+        lists[i] = lnklst_create();
+        copies[i] = lnklst_create();
+        for(j = 0; j < 2000000 / count; j++)
+        {
+            *(int*)lnklst_allocate(lists[i], sizeof(int)) = rand();
+            *(int*)lnklst_allocate(copies[i], sizeof(int)) = *(int*)lnklst_last(lists[i]);
+        };
+        lnklst_sort(lists[i], compare_int);
+        lnklst_sort(copies[i], compare_int);
+    };
+
+    start = now_ns();
+    if(count == 2)
+        lnklst_merge_sorted(lists[0], lists[1], compare_int);
+    else
+        lnklst_merge_sorted_many(dst, lists, count, compare_int);
+    snprintf(line, sizeof(line), "%d lists, %s", count, count == 2 ? "lnklst_merge_sorted()" : "lnklst_merge_sorted_many()");
+    report(line, now_ns() - start, 2000000);
+
+    //merging with a comparison which finds everything equal appends src to dst, but walks dst to do it, so it isn't timed
+    for(i = 1; i < count; i++)
+        lnklst_merge_sorted(copies[0], copies[i], compare_equal);
+    start = now_ns();
+    lnklst_sort(copies[0], compare_int);
+    snprintf(line, sizeof(line), "%d lists, lnklst_sort() of them concatenated", count);
+    report(line, now_ns() - start, 2000000);
+
+    for(i = 0; i < count; i++)
+    {
+        lnklst_destroy(&lists[i]);
+        lnklst_destroy(&copies[i]);
+    };
+    lnklst_destroy(&dst);
+}
+
+static int compare_equal(void *a, void *b)
+{
+    (void)a;
+    (void)b;
+    return 0;
+}
+
+//three lists of the same 2M random ints, built side by side so that their nodes are equally spread through the heap, one for each way
+static void top_k_run(int k)
+{
+    struct lnklst_struct *lists[3];
+    void **top = malloc(k * sizeof(void*));
+    char line[64];
+    int64_t start;
+    int i, j;
+
+    for(i = 0; i < 3; i++)
+        lists[i] = lnklst_create();
+    srand(1);
+    for(j = 0; j < 2000000; j++)
+    {
+        *(int*)lnklst_allocate(lists[0], sizeof(int)) = rand();
+        for(i = 1; i < 3; i++)
+            *(int*)lnklst_allocate(lists[i], sizeof(int)) = *(int*)lnklst_last(lists[0]);
+    };
+
+    start = now_ns();
+    lnklst_top_k(lists[0], k, compare_int, top);
+    snprintf(line, sizeof(line), "k = %d, lnklst_top_k()", k);
+    report(line, now_ns() - start, 2000000);
+
+    start = now_ns();
+    lnklst_partial_sort(lists[1], k, compare_int);
+    snprintf(line, sizeof(line), "k = %d, lnklst_partial_sort()", k);
+    report(line, now_ns() - start, 2000000);
+
+    start = now_ns();
+    lnklst_sort(lists[2], compare_int);
+    snprintf(line, sizeof(line), "k = %d, lnklst_sort()", k);
+    report(line, now_ns() - start, 2000000);
+
+    for(i = 0; i < 3; i++)
+        lnklst_destroy(&lists[i]);
+    free(top);
+}
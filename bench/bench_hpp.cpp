@@ -0,0 +1,119 @@
+	#include <chrono>
+    #include <cstdint>
+    #include <cstdio>
+    #include <cstdlib>
+    #include <list>
+    #include <sys/wait.h>
+    #include <unistd.h>
+
+    #include "../lnklst.hpp"
+
+//********************************************************************************************************
+// Local defines
+//********************************************************************************************************
+
+    //a payload larger than an int, sorted on its key
+    struct record
+    {
+        int key;
+        int data[7];
+
+        explicit record(int key) : key(key) {}
+        bool operator<(const record &other) const { return key < other.key; }
+    };
+
+//********************************************************************************************************
+// Private prototypes
+//********************************************************************************************************
+
+    static int64_t now_ns(void);
+    static void report(const char *list, const char *name, int64_t ns, long ops);
+    template <typename List> static void run(const char *name);
+    template <typename List> static void fresh(const char *name);
+
+//********************************************************************************************************
+// Public functions
+//********************************************************************************************************
+
+int main(int argc, const char* argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    printf("\n1M ints\n");
+    fresh<std::list<int>>("std::list");
+    fresh<lnklst::list<int>>("lnklst::list");
+    printf("\n1M 32 byte records\n");
+    fresh<std::list<record>>("std::list");
+    fresh<lnklst::list<record>>("lnklst::list");
+
+    return 0;
+}
+
+//********************************************************************************************************
+// Private functions
+//********************************************************************************************************
+
+static int64_t now_ns(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char *list, const char *name, int64_t ns, long ops)
+{
+    char line[64];
+
+    snprintf(line, sizeof(line), "%s, %s", list, name);
+    printf("  %-48s %10.1f ns/op  (%ld ops, %.3f s)\n", line, (double)ns / ops, ops, ns / 1e9);
+}
+
+//run in a child process, since a list pushed onto the scattered free blocks left by an earlier run is several times slower than one given fresh pages
+template <typename List>
+static void fresh(const char *name)
+{
+    pid_t child;
+
+    fflush(stdout);
+    child = fork();
+    if(child == 0)
+    {
+        run<List>(name);
+        fflush(stdout);
+        _exit(0);
+    };
+    waitpid(child, NULL, 0);
+}
+
+//emplace 1M random keys, iterate, sort, iterate again in the sorted (scattered) order, and destroy
+template <typename List>
+static void run(const char *name)
+{
+    List *list = new List;
+    volatile long sum = 0;
+    int64_t start;
+    int i;
+
+    srand(1);
+    start = now_ns();
+    for(i = 0; i < 1000000; i++)
+        list->emplace_back(rand());
+    report(name, "emplace_back()", now_ns() - start, 1000000);
+
+    start = now_ns();
+    for(const auto &x : *list)
+        sum += *reinterpret_cast<const int*>(&x);
+    report(name, "iterate", now_ns() - start, 1000000);
+
+    start = now_ns();
+    list->sort();
+    report(name, "sort()", now_ns() - start, 1000000);
+
+    start = now_ns();
+    for(const auto &x : *list)
+        sum += *reinterpret_cast<const int*>(&x);
+    report(name, "iterate sorted", now_ns() - start, 1000000);
+
+    start = now_ns();
+    delete list;
+    report(name, "destroy", now_ns() - start, 1000000);
+}
@@ -1,16 +1,58 @@
-	#define LNKLST_IMPLEMENTATION
-
-//	Mandatory allocator
-	#include <stdlib.h>
-	#define lnklst_platform_alloc(sz)	malloc(sz)
-	#define lnklst_platform_free(ptr)	free(ptr)
-
-//	Optional thread safety
-	#include "pthread.h"
-	#define lnklst_mutex_lock(arg)		pthread_mutex_lock(arg)		
-	#define lnklst_mutex_unlock(arg)	pthread_mutex_unlock(arg)	
-	#define lnklst_mutex_init(arg)		pthread_mutex_init(arg, NULL)		
-	#define lnklst_mutex_destroy(arg)	pthread_mutex_destroy(arg)	
-	#define lnklst_mutex_t				pthread_mutex_t
-
-	#include "lnklst.h"
+	#define LNKLST_IMPLEMENTATION
+
+//	Mandatory allocator
+	#include <stdlib.h>
+	#define lnklst_platform_alloc(sz)	malloc(sz)
+	#define lnklst_platform_realloc(ptr, sz)	realloc(ptr, sz)
+	#define lnklst_platform_free(ptr)	free(ptr)
+
+//	Optional thread safety
+	#include "pthread.h"
+	#define lnklst_mutex_lock(arg)		pthread_mutex_lock(arg)		
+	#define lnklst_mutex_unlock(arg)	pthread_mutex_unlock(arg)	
+	#define lnklst_mutex_init(arg)		pthread_mutex_init(arg, NULL)		
+	#define lnklst_mutex_destroy(arg)	pthread_mutex_destroy(arg)	
+	#define lnklst_mutex_t				pthread_mutex_t
+
+//	Optional process shared mutex, for lists in shared memory
+	static int mutex_init_shared(pthread_mutex_t *mutex)
+	{
+		pthread_mutexattr_t attr;
+		int retval;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+		retval = pthread_mutex_init(mutex, &attr);
+		pthread_mutexattr_destroy(&attr);
+		return retval;
+	}
+	#define lnklst_mutex_init_shared(arg)	mutex_init_shared(arg)
+
+//	Optional blocking queue
+	#include <time.h>
+	static int cond_timedwait_ms(pthread_cond_t *cond, pthread_mutex_t *mutex, int ms)
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += ms / 1000;
+		ts.tv_nsec += (ms % 1000) * 1000000L;
+		if(ts.tv_nsec >= 1000000000L)
+		{
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		};
+		return pthread_cond_timedwait(cond, mutex, &ts);
+	}
+	#define lnklst_cond_init(arg)					pthread_cond_init(arg, NULL)
+	#define lnklst_cond_destroy(arg)				pthread_cond_destroy(arg)
+	#define lnklst_cond_wait(cond, mutex)			pthread_cond_wait(cond, mutex)
+	#define lnklst_cond_timedwait(cond, mutex, ms)	cond_timedwait_ms(cond, mutex, ms)
+	#define lnklst_cond_signal(arg)					pthread_cond_signal(arg)
+	#define lnklst_cond_broadcast(arg)				pthread_cond_broadcast(arg)
+	#define lnklst_cond_t							pthread_cond_t
+
+//	Optional threads for the parallel functions
+	#define lnklst_thread_create(thread, func, arg)	pthread_create(thread, NULL, func, arg)
+	#define lnklst_thread_join(thread)				pthread_join(thread, NULL)
+	#define lnklst_thread_t							pthread_t
+
+	#include "lnklst.h"
@@ -1,443 +1,4537 @@
-/*
-	A doubly linked list, in the form of an allocator wrapper.
-	Use in a similar fashion to malloc/free, only allocations are added to a list, and free's are removed from a list.
-
-	In one C file, define an allocator, then #define LNKLST_IMPLEMENTATION and include this header.
-	Eg.
-
-		#include <stdlib.h>
-		#define lnklst_platform_alloc(sz)			malloc(sz)
-		#define lnklst_platform_realloc(ptr, sz)	realloc(ptr, sz)
-		#define lnklst_platform_free(arg)			free(ptr)
-		#define LNKLST_IMPLEMENTATION
-		#include "lnklst.h"
-
-	lnklst does NOT check for a NULL returned by malloc(), if you want that you need to wrap malloc() with your own error handler.
-	If thread safety is required, you may also define the mutex handling functions/macros, and a type.
-
-	Eg.
-
-		#include <stdlib.h>
-		#define lnklst_platform_alloc(sz)			malloc(sz)
-		#define lnklst_platform_realloc(ptr, sz)	realloc(ptr, sz)
-		#define lnklst_platform_free(arg)			free(ptr)
-
-		//(optional)
-		#include "pthread.h"
-		#define lnklst_mutex_lock(arg)		pthread_mutex_lock(arg)		
-		#define lnklst_mutex_unlock(arg)	pthread_mutex_unlock(arg)	
-		#define lnklst_mutex_init(arg)		pthread_mutex_init(arg, NULL)		
-		#define lnklst_mutex_destroy(arg)	pthread_mutex_destroy(arg)	
-		#define lnklst_mutex_t				pthread_mutex_t
-
-		#define LNKLST_IMPLEMENTATION
-		#include "lnklst.h"
-*/
-
-#ifndef _LNKLST_H_
-#define _LNKLST_H_
-
-	#include <stddef.h>
-
-//********************************************************************************************************
-// Public defines
-//********************************************************************************************************
-
-//	opaque struct
-//	use a pointer to this structure to track the list
-	struct lnklst_struct;
-
-//********************************************************************************************************
-// Public variables
-//********************************************************************************************************
-
-//********************************************************************************************************
-// Public prototypes
-//********************************************************************************************************
-
-//	return a pointer to a new empty linked list
-	struct lnklst_struct* lnklst_create(void);
-
-//	free all allocations in the list, and the list itself
-	void lnklst_destroy(struct lnklst_struct **lst);
-
-//	allocate memory on the heap, and add it to the list
-	void* lnklst_allocate(struct lnklst_struct *lst, size_t size);
-
-//	resize an existing allocation, without breaking it's links
-	void* lnklst_reallocate(struct lnklst_struct *lst, void* allocation, size_t size);
-
-//	free memory from the heap and remove it from the list
-	void lnklst_free(struct lnklst_struct *lst, void* allocation);
-
-//	return the allocation made prior to *allocation if there was one (or NULL)
-	void* lnklst_before(struct lnklst_struct *lst, void *allocation);
-
-//	return the allocation made after *allocation if there was one (or NULL)
-	void* lnklst_after(struct lnklst_struct *lst, void *allocation);
-
-//	return the last (most recent) allocation in the list
-	void* lnklst_last(struct lnklst_struct *lst);
-
-//	return the first (oldest) allocation in the list
-	void* lnklst_first(struct lnklst_struct *lst);
-
-//  return allocation referenced by index, 0-N where 0=the first (oldest) allocation in the list
-	void* lnklst_index(struct lnklst_struct *lst, int index);
-
-//  re-link the list to sort the allocations in an order determined by swapfunc()
-//  If swapfunc(arg1, arg2) returns arg1-arg2, this will sort in ascending order from index 0(oldest/first) onwards
-    void lnklst_sort(struct lnklst_struct *lst, int(*swapfunc)(void*, void*));
-
-//  return a count of the number of allocations in the list
-    int lnklst_count(struct lnklst_struct *lst);
-
-#endif
-#ifdef LNKLST_IMPLEMENTATION
-
-	#include <stdint.h>
-	#include <stdbool.h>
-
-
-//********************************************************************************************************
-// Local defines
-//********************************************************************************************************
-
-	#ifndef lnklst_mutex_lock
-		#define lnklst_mutex_lock(arg)		((void)0)
-	#endif
-
-	#ifndef lnklst_mutex_unlock
-		#define lnklst_mutex_unlock(arg)	((void)0)
-	#endif
-
-	#ifndef lnklst_mutex_init
-		#define lnklst_mutex_init(arg)		((void)0)
-	#endif
-
-	#ifndef lnklst_mutex_destroy
-		#define lnklst_mutex_destroy(arg)	((void)0)
-	#endif
-
-	//serves as a header for allocations, hiding the link in memory before them
-	struct header_struct
-	{
-		struct header_struct *before;	//NULL or the address of the header of the allocation made before this one
-		struct header_struct *after;	//NULL or the address of the header of the allocation made after this one
-		uint8_t	allocation[0] __attribute__((aligned));	//does not add to the size of this structure, only addresses memory after the *after member
-	};
-
-    //holds the head, and a counter
-	struct lnklst_struct
-	{
-	    struct header_struct    head;
-	    int count;
-		#ifdef lnklst_mutex_t
-			lnklst_mutex_t		mutex;
-		#endif
-	};
-
-	#define container_of(ptr, type, member)				\
-	({													\
-		void *__mptr = (void *)(ptr);					\
-		((type *)(__mptr - offsetof(type, member)));	\
-	})
-
-
-//********************************************************************************************************
-// Private prototypes
-//********************************************************************************************************
-
-	static void sort_list(struct lnklst_struct *lst, int(*swapfunc)(void*, void*));
-	static void swap_nodes(struct header_struct **x_ptr, struct header_struct **y_ptr);
-
-//********************************************************************************************************
-// Public functions
-//********************************************************************************************************
-
-struct lnklst_struct* lnklst_create(void)
-{
-	struct lnklst_struct *retval;
-
-	retval = lnklst_platform_alloc(sizeof(struct lnklst_struct));
-
-	retval->head.before = NULL;
-	retval->head.after  = NULL;
-    retval->count        = 0;
-	#ifdef lnklst_mutex_t
-	lnklst_mutex_init(&retval->mutex);
-	#endif
-	return retval;
-}
-
-void* lnklst_allocate(struct lnklst_struct *lst, size_t size)
-{
-	struct header_struct *new_entry;
-	void* retval = NULL;
-
-	if(lst)
-	{
-		lnklst_mutex_lock(&lst->mutex);
-		//allocate new entry
-		new_entry = lnklst_platform_alloc(sizeof(struct header_struct) + size);
-
-		//add new entry to list
-		new_entry->before = lst->head.before;
-		lst->head.before = new_entry;
-		new_entry->after = &lst->head;
-		if(new_entry->before)
-    	    new_entry->before->after = new_entry;
-
-    	lst->count++;
-		retval = &new_entry->allocation;
-		lnklst_mutex_unlock(&lst->mutex);
-	};
-
-	return retval;
-}
-
-void* lnklst_reallocate(struct lnklst_struct *lst, void* allocation, size_t size)
-{
-	struct header_struct  *target;
-	void* retval = NULL;
-
-	if(lst)
-	{
-		lnklst_mutex_lock(&lst->mutex);
-		target = container_of(allocation, struct header_struct, allocation);
-
-		target = lnklst_platform_realloc(target, sizeof(struct header_struct) + size);
-		//update the *before link in the header after this one
-		target->after->before = target;
-		//if there was a header before this one
-		if(target->before)
-    	    //update the *after link in the header before this one
-    	    target->before->after = target;
-		retval = &target->allocation;
-		lnklst_mutex_unlock(&lst->mutex);
-	};
-	return retval;
-}
-
-void lnklst_free(struct lnklst_struct *lst, void* allocation)
-{
-	struct header_struct  *target;
-
-	if(lst)
-	{
-		lnklst_mutex_lock(&lst->mutex);
-		target = container_of(allocation, struct header_struct, allocation);
-
-		//change the *before link in the header after this one, from this header to this headers *before link
-		target->after->before = target->before;
-		//if there was a header before this one
-		if(target->before)
-    	    //change the *after link in the header before this one, from this header to this headers *after link
-    	    target->before->after = target->after;
-
-    	lst->count--;
-		lnklst_platform_free(target);
-		lnklst_mutex_unlock(&lst->mutex);
-	};
-}
-
-void* lnklst_last(struct lnklst_struct *lst)
-{
-	void *retval=NULL;
-
-	if(lst)
-	{
-		lnklst_mutex_lock(&lst->mutex);
-		if(lst->count)
-			retval = &lst->head.before->allocation;
-		lnklst_mutex_unlock(&lst->mutex);
-	};
-
-	return retval;
-}
-
-void* lnklst_first(struct lnklst_struct *lst)
-{
- 	struct header_struct *x;
-    void* retval=NULL;
-	uint32_t index;
-
-	if(lst)
-	{
-		lnklst_mutex_lock(&lst->mutex);
-	    if(lst->count)
-	    {
-			index = lst->count - 1;
-	        x = lst->head.before;
-	        while(index--)
-	            x = x->before;
-	        retval = &x->allocation;
-	    };
-		lnklst_mutex_unlock(&lst->mutex);
-	};
-
-    return retval;
-}
-
-void* lnklst_before(struct lnklst_struct *lst, void *allocation)
-{
-	void				  *retval=NULL;
-	struct header_struct  *header;
-
-	if(lst && allocation)
-	{
-		lnklst_mutex_lock(&lst->mutex);
-		header = container_of(allocation, struct header_struct, allocation);
-
-		if(header->before)		//if there was an allocation before this one
-		{
-			header = header->before;		//point to it
-			retval = &header->allocation;	//and return it's allocation
-		};
-		lnklst_mutex_unlock(&lst->mutex);
-	};
-
-	return retval;
-}
-
-void* lnklst_after(struct lnklst_struct *lst, void *allocation)
-{
-	void				  *retval=NULL;
-	struct header_struct  *header;
-
-	if(lst && allocation)
-	{
-		lnklst_mutex_lock(&lst->mutex);
-		header = container_of(allocation, struct header_struct, allocation);
-
-		if(header->after && (header->after != &lst->head))	    //if there was an allocation after this one
-		{
-			header = header->after;		    //point to it
-			retval = &header->allocation;	//and return it's allocation
-		};
-		lnklst_mutex_unlock(&lst->mutex);
-	};
-
-	return retval;
-}
-
-void lnklst_destroy(struct lnklst_struct **lst)
-{
-	struct header_struct  *hop;
-
-	if(lst && *lst)
-	{
-		lnklst_mutex_lock(&(*lst)->mutex);
-		// while the head still points at something
-		while((*lst)->head.before)
-		{
-			hop = (*lst)->head.before->before;
-			lnklst_platform_free((*lst)->head.before);
-			(*lst)->head.before = hop;
-		};
-		lnklst_mutex_unlock(&(*lst)->mutex);
-		lnklst_mutex_destroy(&(*lst)->mutex);
-        // free the list itself
-        lnklst_platform_free((*lst));
-		*lst = NULL;
-	};
-}
-
-void lnklst_sort(struct lnklst_struct *lst, int(*swapfunc)(void*, void*))
-{
-    if(lst && swapfunc)
-	{
-		lnklst_mutex_lock(&lst->mutex);
-		if(lst->count >1)
-			sort_list(lst, swapfunc);
-		lnklst_mutex_unlock(&lst->mutex);
-	};
-}
-
-int lnklst_count(struct lnklst_struct *lst)
-{
-	int retval = 0;
-	if(lst)
-	{
-		lnklst_mutex_lock(&lst->mutex);
-		retval = lst->count;
-		lnklst_mutex_unlock(&lst->mutex);
-	};
-    return retval;
-}
-
-void* lnklst_index(struct lnklst_struct *lst, int index)
-{
- 	struct header_struct *x;
-    void* retval=NULL;
-
-	if(lst)
-	{
-		lnklst_mutex_lock(&lst->mutex);
-    	if(0 <= index && index < lst->count)
-    	{
-			index = lst->count - 1 - index;
-	        x = lst->head.before;
-        	while(index--)
-	            x = x->before;
-        	retval = &x->allocation;
-    	};
-		lnklst_mutex_unlock(&lst->mutex);
-	};
-
-    return retval;
-}
-
-static void sort_list(struct lnklst_struct *lst, int(*swapfunc)(void*, void*))
-{
-	struct header_struct *x;
-	struct header_struct *y;
-    bool swapped = false;
-
-	do
-	{
-		//start of list
-		x = lst->head.before;
-		y = x->before;
-		swapped = false;
-		//walk the list
-		while(y)
-		{
-			//swap nodes?
-			if(swapfunc(&x->allocation, &y->allocation) < 0)
-			{
-				swap_nodes(&x, &y);
-				swapped = true;   //sort may not be finished
-			};
-			//step
-			x = y;
-			y = y->before;
-		};
-	}while(swapped);
-}
-
-static void swap_nodes(struct header_struct **x_ptr, struct header_struct **y_ptr)
-{
-	struct header_struct *x = *x_ptr;	//de-reference
-	struct header_struct *y = *y_ptr;
-
-	//swap the outer links
-	if(y->before)
-	y->before->after = x;	//(was y)
-	x->after->before = y;	//(was x)
-
-	//swap the inner links
-	y->after  = x->after;
-	x->before = y->before;
-	y->before = x;
-	x->after  = y;
-
-	//swap the x-y to restore head -> x -> y ->end order
-	x = x->after;
-	y = y->before;
-
-	*x_ptr = x;	//re-reference
-	*y_ptr = y;
-}
-
-#endif
+/*
+	A doubly linked list, in the form of an allocator wrapper.
+	Use in a similar fashion to malloc/free, only allocations are added to a list, and free's are removed from a list.
+
+	In one C file, define an allocator, then #define LNKLST_IMPLEMENTATION and include this header.
+	Eg.
+
+		#include <stdlib.h>
+		#define lnklst_platform_alloc(sz)			malloc(sz)
+		#define lnklst_platform_realloc(ptr, sz)	realloc(ptr, sz)
+		#define lnklst_platform_free(arg)			free(ptr)
+		#define LNKLST_IMPLEMENTATION
+		#include "lnklst.h"
+
+	lnklst does NOT check for a NULL returned by malloc(), if you want that you need to wrap malloc() with your own error handler.
+	If thread safety is required, you may also define the mutex handling functions/macros, and a type.
+
+	Eg.
+
+		#include <stdlib.h>
+		#define lnklst_platform_alloc(sz)			malloc(sz)
+		#define lnklst_platform_realloc(ptr, sz)	realloc(ptr, sz)
+		#define lnklst_platform_free(arg)			free(ptr)
+
+		//(optional)
+		#include "pthread.h"
+		#define lnklst_mutex_lock(arg)		pthread_mutex_lock(arg)		
+		#define lnklst_mutex_unlock(arg)	pthread_mutex_unlock(arg)	
+		#define lnklst_mutex_init(arg)		pthread_mutex_init(arg, NULL)		
+		#define lnklst_mutex_destroy(arg)	pthread_mutex_destroy(arg)	
+		#define lnklst_mutex_t				pthread_mutex_t
+
+		#define LNKLST_IMPLEMENTATION
+		#include "lnklst.h"
+
+	Defining LNKLST_EPOCH allows readers to walk a list without taking the mutex, using lnklst_read_enter()/lnklst_read_exit() and the lnklst_read_ functions.
+	Writers still take the mutex, but allocations they free or move are only returned to the platform once every reader which might still see them has left.
+	Functions which relink or move live allocations (sorting, merging, partitioning, detaching, compacting, destroying) must not run while readers are inside, see README.md.
+	This requires GCC/Clang __atomic builtins.
+
+	Walks through long lists may prefetch the headers ahead of them, by defining LNKLST_PREFETCH (GCC/Clang only).
+	LNKLST_PREFETCH_DISTANCE sets how many hops ahead to prefetch (default 4), and LNKLST_PREFETCH_PAYLOAD also prefetches the cache line following each header.
+
+	A list may also be kept in a region of shared memory with lnklst_shm_create(), and used by every process which maps the region.
+	Its links are offsets within the region, and its allocations come from the region rather than the platform allocator.
+	For it to be shared between processes, define lnklst_mutex_init_shared() to initialise a process shared mutex (it defaults to lnklst_mutex_init()).
+
+	Eg.
+
+		#define lnklst_mutex_init_shared(arg)	my_pshared_mutex_init(arg)
+
+	Very large lists may be allocated from large chunks with an arena (lnklst_arena_create()), given to lnklst_create_with_allocator().
+	Chunks are allocated with lnklst_platform_alloc() unless lnklst_platform_chunk_alloc(sz) and lnklst_platform_chunk_free(ptr, sz) are defined, or on Linux
+	LNKLST_HUGEPAGES is defined to map chunks with huge pages (MAP_HUGETLB if huge pages are reserved, otherwise transparent huge pages),
+	and/or LNKLST_NUMA is defined to allocate chunks on the NUMA node of the allocating thread with libnuma (link with -lnuma, and define _GNU_SOURCE for sched_getcpu()).
+	With LNKLST_NUMA the arena allocates from a chunk per node, so threads on one node don't bump into another's memory.
+	Either falls back to ordinary pages if unavailable.
+
+	The blocking queue functions (lnklst_push_wait() etc.) are only available if condition variable functions/macros, and a type, are also defined.
+	lnklst_cond_timedwait() waits for at most ms milliseconds, and must return non-zero if it timed out.
+	Timeouts are measured with clock_gettime(CLOCK_MONOTONIC) where available, or lnklst_clock_ms() if defined, which returns milliseconds from any fixed point.
+
+	Eg.
+
+		#define lnklst_cond_init(arg)					pthread_cond_init(arg, NULL)
+		#define lnklst_cond_destroy(arg)				pthread_cond_destroy(arg)
+		#define lnklst_cond_wait(cond, mutex)			pthread_cond_wait(cond, mutex)
+		#define lnklst_cond_timedwait(cond, mutex, ms)	my_timedwait(cond, mutex, ms)
+		#define lnklst_cond_signal(arg)					pthread_cond_signal(arg)
+		#define lnklst_cond_broadcast(arg)				pthread_cond_broadcast(arg)
+		#define lnklst_cond_t							pthread_cond_t
+
+	lnklst_parallel_foreach() and lnklst_parallel_reduce() only use more than the calling thread if thread functions/macros, and a type, are also defined.
+	lnklst_thread_create() starts func(arg), where func is void*(*)(void*), and must return 0 on success. Otherwise they run on the calling thread.
+
+	Eg.
+
+		#define lnklst_thread_create(thread, func, arg)	pthread_create(thread, NULL, func, arg)
+		#define lnklst_thread_join(thread)				pthread_join(thread, NULL)
+		#define lnklst_thread_t							pthread_t
+*/
+
+#ifndef _LNKLST_H_
+#define _LNKLST_H_
+
+	#include <stddef.h>
+	#include <stdint.h>
+	#include <stdbool.h>
+
+	#ifdef __cplusplus
+	extern "C" {
+	#endif
+
+//********************************************************************************************************
+// Public defines
+//********************************************************************************************************
+
+//	the largest alignment lnklst_allocate_aligned() accepts, a page
+	#define LNKLST_MAX_ALIGNMENT	4096
+
+//	the alignment guaranteed of every block from lnklst_platform_alloc() and custom allocators, to which allocations are aligned without padding
+//	by default that of the largest fundamental type (as for malloc()), define it before including this header where the allocators guarantee otherwise
+	#ifndef LNKLST_PLATFORM_ALIGN
+		#define LNKLST_PLATFORM_ALIGN	(__alignof__(long double) > __alignof__(long long) ? __alignof__(long double) : __alignof__(long long))
+	#endif
+
+//	opaque struct
+//	use a pointer to this structure to track the list
+	struct lnklst_struct;
+
+//	opaque struct
+//	use a pointer to this structure to track an LRU cache
+	struct lnklst_lru_struct;
+
+//	opaque struct
+//	use a pointer to this structure to track an unrolled list
+	struct lnklst_unrolled_struct;
+
+//	opaque struct
+//	use a pointer to this structure to track a snapshot of a list (LNKLST_EPOCH only)
+	struct lnklst_snapshot_struct;
+
+//	opaque struct
+//	use a pointer to this structure to walk a saved list in place, see lnklst_map()
+	struct lnklst_map_struct;
+
+//	opaque struct
+//	use a pointer to this structure to track a list in shared memory
+	struct lnklst_shm_struct;
+
+//	opaque struct
+//	use a pointer to this structure to track an arena, which allocates from large chunks
+	struct lnklst_arena_struct;
+
+//	opaque struct
+//	use a pointer to this structure to track a pool of worker threads
+	struct lnklst_pool_struct;
+
+//	a set of allocator functions for lnklst_create_with_allocator(), each is passed ctx. Blocks must be aligned to LNKLST_PLATFORM_ALIGN
+	struct lnklst_allocator
+	{
+		void*	(*alloc)(size_t size, void *ctx);
+		void*	(*realloc)(void *ptr, size_t size, void *ctx);
+		void	(*free)(void *ptr, void *ctx);
+		void	*ctx;
+	};
+
+//********************************************************************************************************
+// Public variables
+//********************************************************************************************************
+
+//	offset from the start of a node to its allocation, for wrappers (such as lnklst.hpp) which walk the links directly
+//	a node, and the head at the start of a list, begin with their before and after links
+	extern const size_t lnklst_header_size;
+
+//********************************************************************************************************
+// Public prototypes
+//********************************************************************************************************
+
+//	return a pointer to a new empty linked list, or NULL if it could not be allocated
+	struct lnklst_struct* lnklst_create(void);
+
+//	return a pointer to a new empty linked list, whose allocations (and the list itself) are made by allocator rather than the lnklst_platform_ allocator
+//	allocator must remain valid until the list is destroyed. Allocations may only be moved between lists using the same allocator
+	struct lnklst_struct* lnklst_create_with_allocator(const struct lnklst_allocator *allocator);
+
+//	free all allocations in the list, and the list itself
+	void lnklst_destroy(struct lnklst_struct **lst);
+
+//	destroy the list without freeing it's allocations on the caller's thread
+//	the allocations are moved in O(1) to the back of reclaim (a list created for the purpose), then freed by lnklst_reclaim_step()
+//	with LNKLST_EPOCH, allocations still waiting for readers to leave are moved too, so no reader may be inside the list
+//	if reclaim uses a different allocator, the list is destroyed with lnklst_destroy() instead
+	void lnklst_destroy_async(struct lnklst_struct **lst, struct lnklst_struct *reclaim);
+
+//	free up to budget of the first allocations in reclaim, without holding it's lock while freeing
+//	returns the number of allocations remaining, so a reclaimer thread or idle loop knows when it is done
+	int lnklst_reclaim_step(struct lnklst_struct *reclaim, int budget);
+
+//	allocate memory on the heap, and add it to the list
+	void* lnklst_allocate(struct lnklst_struct *lst, size_t size);
+
+//	as lnklst_allocate(), but the allocation is aligned to alignment, which must be a power of 2 no larger than LNKLST_MAX_ALIGNMENT
+//	returns NULL if alignment is not valid. The allocation stays aligned when re-allocated or compacted
+	void* lnklst_allocate_aligned(struct lnklst_struct *lst, size_t size, size_t alignment);
+
+//	resize an existing allocation, without breaking it's links
+	void* lnklst_reallocate(struct lnklst_struct *lst, void* allocation, size_t size);
+
+//	free memory from the heap and remove it from the list
+	void lnklst_free(struct lnklst_struct *lst, void* allocation);
+
+//	return the allocation made prior to *allocation if there was one (or NULL)
+	void* lnklst_before(struct lnklst_struct *lst, void *allocation);
+
+//	return the allocation made after *allocation if there was one (or NULL)
+	void* lnklst_after(struct lnklst_struct *lst, void *allocation);
+
+//	return the last (most recent) allocation in the list
+	void* lnklst_last(struct lnklst_struct *lst);
+
+//	return the first (oldest) allocation in the list
+	void* lnklst_first(struct lnklst_struct *lst);
+
+//  return allocation referenced by index, 0-N where 0=the first (oldest) allocation in the list
+//	the list remembers the last index found, so stepping through indexes in sequence is O(1) per call
+	void* lnklst_index(struct lnklst_struct *lst, int index);
+
+//  re-link the list to sort the allocations in an order determined by swapfunc()
+//  If swapfunc(arg1, arg2) returns arg1-arg2, this will sort in ascending order from index 0(oldest/first) onwards
+//	the sort is stable. The list remembers how many of its first allocations are sorted, and by which swapfunc, until something is put in front of them
+//	sorting again with the same swapfunc then only sorts the allocations added at the back since, and merges them in, in O(m log m + n)
+    void lnklst_sort(struct lnklst_struct *lst, int(*swapfunc)(void*, void*));
+
+//	forget that the list is sorted, so that the next lnklst_sort() sorts all of it
+//	call this after changing allocations in a sorted list in ways which change their order
+	void lnklst_mark_unsorted(struct lnklst_struct *lst);
+
+//	move every allocation in src into dst, where both are already sorted by swapfunc() as for lnklst_sort(), keeping dst sorted
+//	the allocations are re-linked in one pass, with no copying or allocation. Where allocations compare equal, those from dst come first
+//	the two lists are locked in address order, and must use the same allocator or nothing is moved
+	void lnklst_merge_sorted(struct lnklst_struct *dst, struct lnklst_struct *src, int(*swapfunc)(void*, void*));
+
+//	as lnklst_merge_sorted(), moving every allocation from count sorted lists in srcs into dst in O(n log count), using a heap
+//	NULL entries, dst, lists which already appeared earlier in srcs, and lists using another allocator than dst are skipped
+//	dst and the rest are locked in address order
+	void lnklst_merge_sorted_many(struct lnklst_struct *dst, struct lnklst_struct **srcs, int count, int(*swapfunc)(void*, void*));
+
+//	store the k allocations which lnklst_sort() would place first in allocations, in that order, without sorting the list
+//	O(n log k) under one lock, returns the number stored, which is fewer than k if the list is shorter
+//	for the k largest, pass a swapfunc() which sorts in descending order
+	int lnklst_top_k(struct lnklst_struct *lst, int k, int(*swapfunc)(void*, void*), void **allocations);
+
+//	re-link the list so that its first k allocations are those lnklst_sort() would place there, in order
+//	the remaining allocations follow in their original order. O(n log k) under one lock
+	void lnklst_partial_sort(struct lnklst_struct *lst, int k, int(*swapfunc)(void*, void*));
+
+//  return a count of the number of allocations in the list
+    int lnklst_count(struct lnklst_struct *lst);
+
+//	copy size bytes from src (if not NULL) into a new allocation at the back (last) of the list, and return the allocation (NULL if the allocator fails)
+	void* lnklst_push_back(struct lnklst_struct *lst, const void *src, size_t size);
+
+//	copy size bytes from src (if not NULL) into a new allocation at the front (first) of the list, and return the allocation (NULL if the allocator fails)
+	void* lnklst_push_front(struct lnklst_struct *lst, const void *src, size_t size);
+
+//	copy size bytes from the front (first) allocation into dst (if not NULL) and free it, returns false if the list was empty
+	bool lnklst_pop_front(struct lnklst_struct *lst, void *dst, size_t size);
+
+//	copy size bytes from the back (last) allocation into dst (if not NULL) and free it, returns false if the list was empty
+	bool lnklst_pop_back(struct lnklst_struct *lst, void *dst, size_t size);
+
+//	copy size bytes from the front (first) allocation into dst without removing it, returns false if the list was empty
+	bool lnklst_peek_front(struct lnklst_struct *lst, void *dst, size_t size);
+
+//	copy size bytes from the back (last) allocation into dst without removing it, returns false if the list was empty
+	bool lnklst_peek_back(struct lnklst_struct *lst, void *dst, size_t size);
+
+//	re-allocate every allocation in list order, so that walking the list visits memory in sequence rather than scattered across the heap
+//	the allocations are carved one after another from blocks of up to 2MB, each of which is freed once every allocation in it has been
+//	relocfunc(old, new, ctx) is called for each allocation once it has been copied, and before the old allocation is freed, so that any pointers held outside the list can be updated
+//	relocfunc may only be NULL if no pointers to the allocations are held outside the list
+	void lnklst_compact(struct lnklst_struct *lst, void(*relocfunc)(void*, void*, void*), void *ctx);
+
+//	move all allocations into a new list in O(1), leaving lst empty, and return the new list
+//	the new list may then be processed and destroyed without holding up other users of lst
+	struct lnklst_struct* lnklst_detach_all(struct lnklst_struct *lst);
+
+//	free every allocation for which pred(allocation, ctx) returns true, walking the list once under one lock
+//	returns the number of allocations freed
+	int lnklst_remove_if(struct lnklst_struct *lst, bool(*pred)(void*, void*), void *ctx);
+
+//	move every allocation in src for which pred(allocation, ctx) returns true to the back of dst, keeping their order
+//	the two lists are locked in address order, and must use the same allocator or nothing is moved. Returns the number of allocations moved
+	int lnklst_partition(struct lnklst_struct *src, struct lnklst_struct *dst, bool(*pred)(void*, void*), void *ctx);
+
+//	return the first allocation for which pred(allocation, ctx) returns true, or NULL if none do, walking the list once under one lock
+	void* lnklst_find(struct lnklst_struct *lst, bool(*pred)(void*, void*), void *ctx);
+
+//	return the first allocation holding the keylen bytes of key at offset, or NULL if none do
+//	allocations smaller than offset + keylen are skipped, the comparison uses SSE2 where available
+	void* lnklst_find_bytes(struct lnklst_struct *lst, size_t offset, const void *key, size_t keylen);
+
+//	store up to max allocations for which pred(allocation, ctx) returns true in matches, in list order
+//	returns the total number of matches, which may be more than max
+	int lnklst_find_all(struct lnklst_struct *lst, bool(*pred)(void*, void*), void *ctx, void **matches, int max);
+
+//	set the maximum number of allocations lnklst_push_wait() will add to the list before blocking (0 = no limit)
+	void lnklst_set_capacity(struct lnklst_struct *lst, int capacity);
+
+//	copy size bytes from src into a new allocation at the back of the list, waiting up to timeout_ms for space (-1 = forever)
+//	returns false if timed out, or if the list was closed
+	bool lnklst_push_wait(struct lnklst_struct *lst, const void *src, size_t size, int timeout_ms);
+
+//	as lnklst_push_wait(), but for an array of count elements, waking consumers once per batch rather than per element
+//	returns the number of elements added
+	int lnklst_push_wait_many(struct lnklst_struct *lst, const void *src, size_t size, int count, int timeout_ms);
+
+//	copy size bytes from the front of the list into dst (if not NULL) and free it, waiting up to timeout_ms for an allocation (-1 = forever)
+//	returns false if timed out, or if the list was closed and is now empty
+	bool lnklst_pop_wait(struct lnklst_struct *lst, void *dst, size_t size, int timeout_ms);
+
+//	as lnklst_pop_wait(), but takes up to max elements into the array dst once at least one is available, waking producers once per batch
+//	returns the number of elements taken
+	int lnklst_pop_wait_many(struct lnklst_struct *lst, void *dst, size_t size, int max, int timeout_ms);
+
+//	close the list to lnklst_push_wait(), and wake all waiters. Remaining allocations may still be drained with lnklst_pop_wait()
+	void lnklst_close(struct lnklst_struct *lst);
+
+//	return a pointer to a new empty LRU cache, holding at most max_count entries and max_bytes of payload (0 = no limit)
+//	keyfunc() returns the address of the key within an entry, hashfunc() hashes a key, and keycmp() returns 0 for equal keys
+//	evictfunc() is optional (may be NULL), and is called for every entry leaving the cache
+	struct lnklst_lru_struct* lnklst_lru_create(int max_count, size_t max_bytes, void*(*keyfunc)(void*), uint32_t(*hashfunc)(void*), int(*keycmp)(void*, void*), void(*evictfunc)(void*));
+
+//	free all entries in the cache, and the cache itself
+	void lnklst_lru_destroy(struct lnklst_lru_struct **lru);
+
+//	copy size bytes from data into the cache as the most recently used entry, replacing any entry with the same key
+//	least recently used entries are evicted to stay within capacity, returns the cached copy
+	void* lnklst_lru_put(struct lnklst_lru_struct *lru, const void *data, size_t size);
+
+//	return the entry matching key and mark it as the most recently used, or NULL if there is no match
+	void* lnklst_lru_get(struct lnklst_lru_struct *lru, void *key);
+
+//	remove the entry matching key from the cache, returns true if there was a match
+	bool lnklst_lru_evict(struct lnklst_lru_struct *lru, void *key);
+
+//	return a count of the number of entries in the cache
+	int lnklst_lru_count(struct lnklst_lru_struct *lru);
+
+//	return a pointer to a new empty unrolled list, which stores elements of elem_size bytes in blocks of elems_per_block
+//	this saves the memory and traversal cost of a header per element, for lists of small records
+	struct lnklst_unrolled_struct* lnklst_create_unrolled(size_t elem_size, int elems_per_block);
+
+//	free all elements in the unrolled list, and the list itself
+	void lnklst_unrolled_destroy(struct lnklst_unrolled_struct **lst);
+
+//	add an element to the end of the unrolled list, and return it
+	void* lnklst_unrolled_allocate(struct lnklst_unrolled_struct *lst);
+
+//	remove an element from the unrolled list. The elements after it in the same block move down, so pointers to them are no longer valid
+	void lnklst_unrolled_free(struct lnklst_unrolled_struct *lst, void *element);
+
+//	return the element before *element if there was one (or NULL)
+	void* lnklst_unrolled_before(struct lnklst_unrolled_struct *lst, void *element);
+
+//	return the element after *element if there was one (or NULL)
+	void* lnklst_unrolled_after(struct lnklst_unrolled_struct *lst, void *element);
+
+//	return the first (oldest) element in the unrolled list
+	void* lnklst_unrolled_first(struct lnklst_unrolled_struct *lst);
+
+//	return the last (most recent) element in the unrolled list
+	void* lnklst_unrolled_last(struct lnklst_unrolled_struct *lst);
+
+//	return element referenced by index, 0-N where 0=the first (oldest) element in the list
+	void* lnklst_unrolled_index(struct lnklst_unrolled_struct *lst, int index);
+
+//	sort the elements in an order determined by swapfunc(), which is the same as for lnklst_sort(), keeping equal elements in order
+//	elements are moved rather than re-linked, so pointers to them are no longer valid
+	void lnklst_unrolled_sort(struct lnklst_unrolled_struct *lst, int(*swapfunc)(void*, void*));
+
+//	return a count of the number of elements in the unrolled list
+	int lnklst_unrolled_count(struct lnklst_unrolled_struct *lst);
+
+//	(LNKLST_EPOCH only) enter a read-side critical section, in which the lnklst_read_ functions may be used without locking
+//	allocations freed by writers are not returned to the platform until the reader leaves. Returns a token for lnklst_read_exit()
+	int lnklst_read_enter(struct lnklst_struct *lst);
+
+//	(LNKLST_EPOCH only) leave the read-side critical section entered by lnklst_read_enter()
+	void lnklst_read_exit(struct lnklst_struct *lst, int token);
+
+//	(LNKLST_EPOCH only) lock free lnklst_first(), lnklst_last(), lnklst_before() and lnklst_after(), for use inside a read-side critical section
+	void* lnklst_read_first(struct lnklst_struct *lst);
+	void* lnklst_read_last(struct lnklst_struct *lst);
+	void* lnklst_read_before(struct lnklst_struct *lst, void *allocation);
+	void* lnklst_read_after(struct lnklst_struct *lst, void *allocation);
+
+//	(LNKLST_EPOCH only) take a read-only view of the list as it is now. The list is only locked while the snapshot is taken,
+//	writers may then continue, and allocations freed or re-allocated after the snapshot are kept until it is released
+//	the snapshot holds the list's epoch like a reader, so nothing freed from the list while it is held is returned, not only what it captured:
+//	memory grows with every free until release, on top of count pointers for the snapshot itself. Keep snapshots of busy lists short lived
+	struct lnklst_snapshot_struct* lnklst_snapshot(struct lnklst_struct *lst);
+
+//	(LNKLST_EPOCH only) release a snapshot. This must be done before the list is destroyed. Takes the address of a pointer, and will NULL the pointer
+	void lnklst_snapshot_release(struct lnklst_snapshot_struct **snap);
+
+//	(LNKLST_EPOCH only) return the number of allocations in a snapshot
+	int lnklst_snapshot_count(struct lnklst_snapshot_struct *snap);
+
+//	(LNKLST_EPOCH only) return the allocation at index in a snapshot, or NULL if out of range. O(1)
+	void* lnklst_snapshot_index(struct lnklst_snapshot_struct *snap, int index);
+
+//	write the list through writefunc(src, len, ctx), which returns false on failure, as a header followed by each allocation prefixed by its size
+//	if checksum is true, a checksum is appended which lnklst_load() and lnklst_map() will verify. Returns false if writefunc failed
+//	the format is native endian, and records are aligned to 16 bytes so that a saved list can be walked in place with lnklst_map()
+	bool lnklst_save(struct lnklst_struct *lst, bool checksum, bool(*writefunc)(const void*, size_t, void*), void *ctx);
+
+//	return a new list read through readfunc(dst, len, ctx), which returns false on failure, from the format written by lnklst_save()
+//	returns NULL if the data is truncated, not in the format, or fails the checksum
+//	allocations are grown as their data is read, so a corrupt image can't claim more memory than it supplies
+	struct lnklst_struct* lnklst_load(bool(*readfunc)(void*, size_t, void*), void *ctx);
+
+//	validate an image written by lnklst_save() which is already in memory (such as a mapped file) and return a read-only view of it, or NULL if invalid
+//	nothing is allocated, the view is valid for as long as image is. image must be 16 byte aligned
+	const struct lnklst_map_struct* lnklst_map(const void *image, size_t length);
+
+//	return the number of allocations in a mapped image
+	int lnklst_map_count(const struct lnklst_map_struct *map);
+
+//	return the first allocation in a mapped image, or NULL if it is empty
+	const void* lnklst_map_first(const struct lnklst_map_struct *map);
+
+//	return the allocation after *allocation in a mapped image, or NULL if it was the last
+	const void* lnklst_map_after(const struct lnklst_map_struct *map, const void *allocation);
+
+//	return the size of an allocation in a mapped image
+	size_t lnklst_map_size(const struct lnklst_map_struct *map, const void *allocation);
+
+//	create an empty list occupying the region of size bytes, which must be 16 byte aligned, returns NULL if the region is too small
+//	the region may be mapped at different addresses by different processes, and its allocations are only made from within it
+	struct lnklst_shm_struct* lnklst_shm_create(void *region, size_t size);
+
+//	return the list already created in region by another process, or NULL if there isn't one
+	struct lnklst_shm_struct* lnklst_shm_attach(void *region);
+
+//	destroy the list's mutex once no process is using the list. The region itself belongs to the caller
+	void lnklst_shm_destroy(struct lnklst_shm_struct *shm);
+
+//	allocate memory from the region, and add it to the end of the list. Returns NULL if the region has no space
+	void* lnklst_shm_allocate(struct lnklst_shm_struct *shm, size_t size);
+
+//	return memory to the region, and remove it from the list
+	void lnklst_shm_free(struct lnklst_shm_struct *shm, void *allocation);
+
+//	copy size bytes from src into a new allocation at the back of the list, under the lock so that no other process sees it part written
+//	returns the allocation, or NULL if the region has no space
+	void* lnklst_shm_push_back(struct lnklst_shm_struct *shm, const void *src, size_t size);
+
+//	copy size bytes from the front allocation into dst (if not NULL) and free it, returns false if the list was empty
+	bool lnklst_shm_pop_front(struct lnklst_shm_struct *shm, void *dst, size_t size);
+
+//	as lnklst_before(), lnklst_after(), lnklst_first(), lnklst_last() and lnklst_count(), for a list in shared memory
+	void* lnklst_shm_before(struct lnklst_shm_struct *shm, void *allocation);
+	void* lnklst_shm_after(struct lnklst_shm_struct *shm, void *allocation);
+	void* lnklst_shm_first(struct lnklst_shm_struct *shm);
+	void* lnklst_shm_last(struct lnklst_shm_struct *shm);
+	int lnklst_shm_count(struct lnklst_shm_struct *shm);
+
+//	re-link the list into the order given by an array of all count of its allocations, in O(count)
+//	for callers which sort the allocations themselves. Does nothing if count is not the number of allocations in the list
+//	the list is only locked while re-linking, so no allocation may be freed between gathering the array and reordering (use lnklst_sort_gathered() on a shared list)
+	void lnklst_reorder(struct lnklst_struct *lst, void **allocations, int count);
+
+//	copy up to max of the list's allocations, in order, into the array allocations under one lock, and return the number copied
+//	for callers which sort the allocations themselves, along with lnklst_reorder()
+	int lnklst_gather(struct lnklst_struct *lst, void **allocations, int max);
+
+//	gather the list's allocations into an array, have sortfunc(allocations, count, ctx) put the array in order, and re-link the list to match
+//	the list is locked throughout, so sortfunc must not call lnklst functions on the same list
+	void lnklst_sort_gathered(struct lnklst_struct *lst, void(*sortfunc)(void**, int, void*), void *ctx);
+
+//********************************************************************************************************
+// Typed lists
+//********************************************************************************************************
+
+//	LNKLST_DEFINE_TYPED(name, T, cmp_expr) defines static inline functions for a list of T, with its element size and comparison known at compile time
+//	cmp_expr compares const T *a with const T *b, and is > 0 if a should come after b, in the same way as a swapfunc for lnklst_sort()
+//	name_sort() sorts with the comparison inlined through lnklst_sort_gathered(), needing scratch memory from LNKLST_TYPED_ALLOC()/LNKLST_TYPED_FREE() (default malloc()/free())
+//	Eg.
+//		LNKLST_DEFINE_TYPED(points, struct point, a->x - b->x)
+//		points_push_back(lst, (struct point){1, 2});
+//		points_sort(lst);
+
+	#ifndef LNKLST_TYPED_ALLOC
+		#include <stdlib.h>
+		#define LNKLST_TYPED_ALLOC(size)	malloc(size)
+		#define LNKLST_TYPED_FREE(ptr)		free(ptr)
+	#endif
+
+	#define LNKLST_DEFINE_TYPED(name, T, cmp_expr)															\
+																											\
+	static inline int name##_cmp(const T *a, const T *b) { return (cmp_expr); }							\
+	static inline T* name##_allocate(struct lnklst_struct *lst) { return (T*)lnklst_allocate(lst, sizeof(T)); }	\
+	static inline T* name##_push_back(struct lnklst_struct *lst, T value) { return (T*)lnklst_push_back(lst, &value, sizeof(T)); }	\
+	static inline T* name##_push_front(struct lnklst_struct *lst, T value) { return (T*)lnklst_push_front(lst, &value, sizeof(T)); }	\
+	static inline bool name##_pop_front(struct lnklst_struct *lst, T *dst) { return lnklst_pop_front(lst, dst, sizeof(T)); }	\
+	static inline bool name##_pop_back(struct lnklst_struct *lst, T *dst) { return lnklst_pop_back(lst, dst, sizeof(T)); }	\
+	static inline T* name##_first(struct lnklst_struct *lst) { return (T*)lnklst_first(lst); }				\
+	static inline T* name##_last(struct lnklst_struct *lst) { return (T*)lnklst_last(lst); }				\
+	static inline T* name##_before(struct lnklst_struct *lst, T *element) { return (T*)lnklst_before(lst, element); }	\
+	static inline T* name##_after(struct lnklst_struct *lst, T *element) { return (T*)lnklst_after(lst, element); }	\
+	static inline T* name##_index(struct lnklst_struct *lst, int index) { return (T*)lnklst_index(lst, index); }	\
+	static inline int name##_count(struct lnklst_struct *lst) { return lnklst_count(lst); }				\
+																											\
+	/* stable bottom up merge sort of the gathered allocations, called with the list locked */			\
+	static inline void name##_sort_gathered(void **array, int count, void *ctx)							\
+	{																										\
+		void **scratch, **src, **dst, **swap;																\
+		int width, lo, mid, hi, i, j, k;																	\
+																											\
+		(void)ctx;																							\
+		if(count > 1)																						\
+		{																									\
+			scratch = (void**)LNKLST_TYPED_ALLOC(count * sizeof(void*));									\
+			src = array;																					\
+			dst = scratch;																					\
+			for(width = 1; width < count; width *= 2)														\
+			{																								\
+				for(lo = 0; lo < count; lo += 2 * width)													\
+				{																							\
+					mid = (lo + width < count) ? lo + width : count;										\
+					hi = (lo + 2 * width < count) ? lo + 2 * width : count;									\
+					i = lo;																					\
+					j = mid;																				\
+					k = lo;																					\
+					while(i < mid && j < hi)																\
+						dst[k++] = (name##_cmp((const T*)src[i], (const T*)src[j]) > 0) ? src[j++] : src[i++];	\
+					while(i < mid)																			\
+						dst[k++] = src[i++];																\
+					while(j < hi)																			\
+						dst[k++] = src[j++];																\
+				};																							\
+				swap = src;																					\
+				src = dst;																					\
+				dst = swap;																					\
+			};																								\
+			for(i = 0; src != array && i < count; i++)														\
+				array[i] = src[i];																			\
+			LNKLST_TYPED_FREE(scratch);																		\
+		};																									\
+	}																										\
+																											\
+	/* sort the list, gathering, sorting and re-linking under one lock */									\
+	static inline void name##_sort(struct lnklst_struct *lst) { lnklst_sort_gathered(lst, name##_sort_gathered, NULL); }
+
+//	return a pointer to a new arena, which allocates from chunks of chunk_size bytes (rounded up to a huge page with LNKLST_HUGEPAGES)
+//	a chunk is returned to the platform once every allocation in it has been freed. Allocations larger than a chunk get a chunk of their own
+//	chunk_size is raised to at least room for one small allocation, and NULL is returned if it is too large to round up
+	struct lnklst_arena_struct* lnklst_arena_create(size_t chunk_size);
+
+//	free every chunk, and the arena itself. Lists using the arena must be destroyed first
+	void lnklst_arena_destroy(struct lnklst_arena_struct **arena);
+
+//	return the allocator to pass to lnklst_create_with_allocator(), for lists allocated from the arena
+	const struct lnklst_allocator* lnklst_arena_allocator(struct lnklst_arena_struct *arena);
+
+//	call fn(allocation, ctx) for every allocation, splitting the list into up to nthreads segments which are walked in parallel
+//	the list is locked throughout, so fn must not call lnklst functions on the same list
+	void lnklst_parallel_foreach(struct lnklst_struct *lst, void(*fn)(void*, void*), void *ctx, int nthreads);
+
+//	reduce the list into result, an accumulator of size bytes, splitting it into up to nthreads segments which are walked in parallel
+//	each segment's accumulator starts as a copy of identity, and map(acc, allocation) folds each allocation into it
+//	result is then set to identity, and combine(result, acc) folds in each segment's accumulator, in list order, on the calling thread
+//	the list is locked throughout, so map must not call lnklst functions on the same list
+	void lnklst_parallel_reduce(struct lnklst_struct *lst, void(*map)(void*, void*), void(*combine)(void*, void*), const void *identity, void *result, size_t size, int nthreads);
+
+//	return a pointer to a new pool of nthreads worker threads, for lnklst_pool_foreach() and lnklst_pool_reduce()
+//	the list is split into several segments per thread, which each worker takes from its own queue, or steals from others once that is empty
+//	without thread and condition variable functions/macros (see lnklst.h) the pool has no workers, and the calling thread does all of the work
+	struct lnklst_pool_struct* lnklst_pool_create(int nthreads);
+
+//	stop and join the pool's threads, and free the pool
+	void lnklst_pool_destroy(struct lnklst_pool_struct **pool);
+
+//	as lnklst_parallel_foreach(), using the pool's threads and the calling thread
+	void lnklst_pool_foreach(struct lnklst_pool_struct *pool, struct lnklst_struct *lst, void(*fn)(void*, void*), void *ctx);
+
+//	as lnklst_parallel_reduce(), using the pool's threads and the calling thread
+	void lnklst_pool_reduce(struct lnklst_pool_struct *pool, struct lnklst_struct *lst, void(*map)(void*, void*), void(*combine)(void*, void*), const void *identity, void *result, size_t size);
+
+	#ifdef __cplusplus
+	}
+	#endif
+
+#endif
+#ifdef LNKLST_IMPLEMENTATION
+
+	#include <stdlib.h>
+	#include <string.h>
+
+	#ifdef __SSE2__
+		#include <emmintrin.h>
+	#endif
+
+	#if defined(lnklst_cond_t) && !defined(lnklst_clock_ms)
+		#include <time.h>
+	#endif
+
+	#if !defined(lnklst_platform_chunk_alloc) && (defined(LNKLST_HUGEPAGES) || defined(LNKLST_NUMA))
+		#include <sys/mman.h>
+		#ifdef LNKLST_NUMA
+			#include <numa.h>
+			#include <sched.h>
+		#endif
+	#endif
+
+
+//********************************************************************************************************
+// Local defines
+//********************************************************************************************************
+
+	#ifndef lnklst_mutex_lock
+		#define lnklst_mutex_lock(arg)		((void)0)
+	#endif
+
+	#ifndef lnklst_mutex_unlock
+		#define lnklst_mutex_unlock(arg)	((void)0)
+	#endif
+
+	#ifndef lnklst_mutex_init
+		#define lnklst_mutex_init(arg)		((void)0)
+	#endif
+
+	#ifndef lnklst_mutex_destroy
+		#define lnklst_mutex_destroy(arg)	((void)0)
+	#endif
+
+	#ifndef lnklst_mutex_init_shared
+		#define lnklst_mutex_init_shared(arg)	lnklst_mutex_init(arg)
+	#endif
+
+	#ifdef LNKLST_PREFETCH
+		#ifndef LNKLST_PREFETCH_DISTANCE
+			#define LNKLST_PREFETCH_DISTANCE	4
+		#endif
+		#ifdef LNKLST_PREFETCH_PAYLOAD
+			#define lnklst_prefetch(x)	do{__builtin_prefetch(x); __builtin_prefetch((uint8_t*)(x) + 64);}while(0)
+		#else
+			#define lnklst_prefetch(x)	__builtin_prefetch(x)
+		#endif
+	#else
+		#define LNKLST_PREFETCH_DISTANCE	0
+		#define lnklst_prefetch(x)			((void)0)
+	#endif
+
+	//alignment of an allocation which follows its header at the start of a block, no more than the allocator guarantees
+	#define NODE_ALIGN	LNKLST_PLATFORM_ALIGN
+
+	//serves as a header for allocations, hiding the link in memory before them
+	struct header_struct
+	{
+		struct header_struct *before;	//NULL or the address of the header of the allocation made before this one
+		struct header_struct *after;	//NULL or the address of the header of the allocation made after this one (the head's *after is the first allocation)
+		size_t	size;					//size of the allocation
+		uint32_t	pad;				//bytes before the header in its block, to align the allocation, or from the start of its slab
+		uint32_t	alignment : 31;		//0, or the alignment requested by lnklst_allocate_aligned()
+		uint32_t	slab : 1;			//carved from a slab by lnklst_compact(), rather than being a block of its own
+		#ifdef LNKLST_EPOCH
+			struct header_struct *retired;	//next in the list of allocations waiting for readers to leave
+		#endif
+		uint8_t	allocation[0] __attribute__((aligned(NODE_ALIGN)));	//does not add to the size of this structure, only addresses memory after the *after member
+	};
+
+    //holds the head, and a counter
+	struct lnklst_struct
+	{
+	    struct header_struct    head;
+	    int count;
+		const struct lnklst_allocator	*allocator;	//NULL to use the lnklst_platform_ allocator
+		struct header_struct	*finger;	//NULL, or the header last found by lnklst_index()
+		int		finger_index;
+		int		(*sorted_by)(void*, void*);	//the swapfunc the first sorted_count allocations are known to be sorted by
+		int		sorted_count;
+		#ifdef LNKLST_EPOCH
+			unsigned	epoch;
+			int			readers[2];					//readers in odd and even epochs
+			struct header_struct	*limbo[2];		//allocations retired in odd and even epochs
+		#endif
+		#ifdef lnklst_mutex_t
+			lnklst_mutex_t		mutex;
+		#endif
+		#ifdef lnklst_cond_t
+			lnklst_cond_t		not_empty;
+			lnklst_cond_t		not_full;
+			int		capacity;		//0 = no limit
+			int		waiting_pop;	//number of threads waiting on not_empty
+			int		waiting_push;	//number of threads waiting on not_full
+			bool	closed;
+		#endif
+	};
+
+	//the header of a saved list, which is also the view of it returned by lnklst_map()
+	struct lnklst_map_struct
+	{
+		uint32_t	magic;
+		uint16_t	version;
+		uint16_t	flags;
+		uint32_t	count;
+		uint32_t	reserved;
+		uint64_t	bytes;		//size of the records which follow, not including any checksum after them
+		uint64_t	reserved2;
+	};
+
+	//precedes each allocation in a saved list
+	struct image_record_struct
+	{
+		uint64_t	size;
+		uint64_t	reserved;
+		uint8_t		payload[];
+	};
+
+	#define IMAGE_MAGIC			0x4C4B4E4Cu		//"LNKL" in little endian, so a foreign endian image is rejected
+	#define IMAGE_VERSION		1
+	#define IMAGE_CHECKSUM		0x0001			//a 64 bit checksum follows the records
+	#define IMAGE_ALIGN			16
+	#define IMAGE_HASH_INIT		0xCBF29CE484222325ull
+	#define image_round(size)	(((size) + IMAGE_ALIGN - 1) & ~(uint64_t)(IMAGE_ALIGN - 1))
+	#define IMAGE_LOAD_CHUNK	(64 * 1024)		//first read of a payload, which then doubles, so a corrupt size can't allocate much more than was really read
+
+	//sits at the start of a shared region. All links are offsets from here, 0 meaning none
+	struct lnklst_shm_struct
+	{
+		uint32_t	magic;
+		int			count;
+		uint64_t	size;		//size of the region
+		uint64_t	first;
+		uint64_t	last;
+		uint64_t	free;		//first free block, free blocks are kept in address order
+		#ifdef lnklst_mutex_t
+			lnklst_mutex_t		mutex;
+		#endif
+	} __attribute__((aligned(16)));
+
+	//a block of a shared region, either an allocation in the list, or free (when *after links the next free block)
+	struct shm_block_struct
+	{
+		uint64_t	size;		//size of the block including this header
+		uint64_t	before;
+		uint64_t	after;
+		uint64_t	used;		//size of the allocation
+		uint8_t		allocation[] __attribute__((aligned(16)));
+	};
+
+	#define SHM_MAGIC					0x4C4B5348u
+	#define SHM_ALIGN					16
+	#define shm_round(size)				(((size) + SHM_ALIGN - 1) & ~(size_t)(SHM_ALIGN - 1))
+	#define shm_block(shm, offset)		((struct shm_block_struct*)((uint8_t*)(shm) + (offset)))
+	#define shm_offset(shm, block)		((uint64_t)((uint8_t*)(block) - (uint8_t*)(shm)))
+
+	#ifdef LNKLST_EPOCH
+	//a list captured as an array of allocations, pinning the epoch it was taken in
+	struct lnklst_snapshot_struct
+	{
+		struct lnklst_struct	*lst;
+		int		token;
+		int		count;
+		void	*allocations[];
+	};
+	#endif
+
+	//a block which lnklst_compact() carves nodes from in list order, freed once every node in it has been
+	struct compact_slab_struct
+	{
+		int		live;			//nodes in the slab not yet freed
+	} __attribute__((aligned(NODE_ALIGN)));
+
+	#define COMPACT_SLAB_SIZE	(2 * 1024 * 1024)	//largest slab, unless a single node needs more, so that a few survivors can't keep much memory
+
+	//an arena's chunk, followed by its allocations
+	struct arena_chunk_struct
+	{
+		struct arena_chunk_struct	*before;
+		struct arena_chunk_struct	*after;
+		size_t	size;			//size of the chunk including this header
+		size_t	used;
+		int		live;			//allocations not yet freed
+		int		node;			//NUMA node it is bound to, and allocated from by
+	} __attribute__((aligned(NODE_ALIGN)));
+
+	//precedes each allocation from an arena
+	struct arena_prefix_struct
+	{
+		struct arena_chunk_struct	*chunk;
+		size_t	size;
+	} __attribute__((aligned(NODE_ALIGN)));
+
+	struct lnklst_arena_struct
+	{
+		struct lnklst_allocator		allocator;	//ctx is the arena
+		size_t	chunk_size;
+		struct arena_chunk_struct	*chunks;	//every chunk
+		#ifdef lnklst_mutex_t
+			lnklst_mutex_t		mutex;
+		#endif
+		int		nodes;
+		struct arena_chunk_struct	*current[];	//per NUMA node, the chunk being allocated from
+	};
+
+	#define HUGE_PAGE_SIZE	(2 * 1024 * 1024)
+	#define ARENA_MIN_CHUNK	(sizeof(struct arena_chunk_struct) + sizeof(struct arena_prefix_struct) + sizeof(struct header_struct) + NODE_ALIGN)
+
+	//a run of the list, from first up to (not including) end, for lnklst_parallel_ functions
+	struct parallel_segment_struct
+	{
+		struct header_struct	*first;
+		struct header_struct	*end;
+		void	(*fn)(void*, void*);	//called with each allocation and ctx, or
+		void	*ctx;
+		void	(*map)(void*, void*);	//called with acc and each allocation
+		void	*acc;
+		#ifdef lnklst_thread_t
+			lnklst_thread_t		thread;
+			bool	threaded;
+		#endif
+	};
+
+	//a pool needs threads, and condition variables to wake them
+	#if defined(lnklst_thread_t) && defined(lnklst_cond_t)
+		#define POOL_THREADS
+	#endif
+
+	//segments per thread of a pool, which can be stolen to balance the load
+	#define POOL_CHUNKS	4
+
+	//enough levels of sort_chain() to merge INT_MAX allocations
+	#define SORT_LEVELS	32
+
+	//an allocation held in a heap, and its order (list or position) which breaks ties
+	struct heap_entry_struct
+	{
+		struct header_struct	*node;
+		int		order;
+	};
+
+	//a worker's queue of segments, the range top to bottom. The owner takes from the top, and thieves from the bottom
+	struct pool_worker_struct
+	{
+		#ifdef POOL_THREADS
+			struct lnklst_pool_struct	*pool;
+			int		index;
+			int		top;
+			int		bottom;
+			lnklst_mutex_t		mutex;
+			lnklst_thread_t		thread;
+			bool	started;
+		#endif
+	};
+
+	struct lnklst_pool_struct
+	{
+		int		nworkers;
+		#ifdef POOL_THREADS
+			struct parallel_segment_struct	*segments;	//of the current job
+			int		remaining;		//segments of the current job not yet finished
+			int		busy;			//workers in the current job
+			unsigned	generation;	//counts jobs, so workers know when there is a new one
+			bool	stop;
+			lnklst_mutex_t		mutex;
+			lnklst_mutex_t		run;	//one job at a time
+			lnklst_cond_t		work;
+			lnklst_cond_t		done;
+		#endif
+		struct pool_worker_struct	workers[];	//nworkers, and one for the calling thread
+	};
+
+	#define container_of(ptr, type, member)				\
+	({													\
+		void *__mptr = (void *)(ptr);					\
+		((type *)(__mptr - offsetof(type, member)));	\
+	})
+
+	//links which lock free readers may be following are stored with release, and loaded with acquire semantics
+	#ifdef LNKLST_EPOCH
+		#define link_store(link, value)	__atomic_store_n(&(link), (value), __ATOMIC_RELEASE)
+		#define link_load(link)			__atomic_load_n(&(link), __ATOMIC_ACQUIRE)
+	#else
+		#define link_store(link, value)	((link) = (value))
+		#define link_load(link)			(link)
+	#endif
+
+	//the link that chains unlinked headers waiting to be freed, readers may still be stood on them in LNKLST_EPOCH mode so their own links are left alone
+	#ifdef LNKLST_EPOCH
+		#define chain_next(header)	((header)->retired)
+	#else
+		#define chain_next(header)	((header)->before)
+	#endif
+
+	#define LRU_INITIAL_BUCKETS	16
+
+	//serves as a header for cache entries, chaining them into the hash index
+	struct lru_entry_struct
+	{
+		struct lru_entry_struct *next;	//NULL or the next entry in the same bucket
+		size_t		size;
+		uint32_t	hash;
+		uint8_t	data[0] __attribute__((aligned(NODE_ALIGN)));
+	};
+
+	//entries are allocations in lst, ordered from least (first) to most (last) recently used
+	struct lnklst_lru_struct
+	{
+		struct lnklst_struct	*lst;
+		struct lru_entry_struct	**buckets;
+		uint32_t	bucket_count;	//always a power of 2
+		int			max_count;
+		size_t		max_bytes;
+		size_t		bytes;
+		void*		(*keyfunc)(void*);
+		uint32_t	(*hashfunc)(void*);
+		int			(*keycmp)(void*, void*);
+		void		(*evictfunc)(void*);
+	};
+
+
+	//payload of each block in an unrolled list
+	struct unrolled_block_struct
+	{
+		int		used;	//number of elements in use, from the start of elements[]
+		uint8_t	elements[0] __attribute__((aligned(NODE_ALIGN)));
+	};
+
+	//blocks are allocations in lst, the finger is the block last found by an element or index lookup
+	struct lnklst_unrolled_struct
+	{
+		struct lnklst_struct	*blocks;
+		size_t	elem_size;
+		int		elems_per_block;
+		int		count;
+		struct header_struct	*finger;	//NULL or a block
+		int		finger_index;				//index of the first element in the finger block
+	};
+
+	#define block_of(header)	((struct unrolled_block_struct*)&(header)->allocation)
+
+//********************************************************************************************************
+// Private prototypes
+//********************************************************************************************************
+
+	static void link_last(struct lnklst_struct *lst, struct header_struct *entry);
+	static inline void* node_alloc(struct lnklst_struct *lst, size_t size);
+	static inline void* node_realloc(struct lnklst_struct *lst, void *ptr, size_t size);
+	static inline void node_free(struct lnklst_struct *lst, void *ptr);
+	static struct header_struct* new_node(struct lnklst_struct *lst, size_t size);
+	static struct header_struct* new_node_aligned(struct lnklst_struct *lst, size_t size, size_t alignment);
+	static void release_node(struct lnklst_struct *lst, struct header_struct *header);
+	static size_t slab_footprint(struct header_struct *header);
+	static struct header_struct* slab_carve(struct compact_slab_struct *slab, size_t *used, struct header_struct *header);
+	static inline struct header_struct* prefetch_ahead(struct lnklst_struct *lst, struct header_struct *ahead, int hops, bool forward);
+	static void replace_node(struct lnklst_struct *lst, struct header_struct *old, struct header_struct *entry);
+	static void link_first(struct lnklst_struct *lst, struct header_struct *entry);
+	static void unlink_node(struct lnklst_struct *lst, struct header_struct *entry);
+	static inline bool bytes_equal(const uint8_t *a, const uint8_t *b, size_t length);
+	static void splice_last(struct lnklst_struct *dst, struct lnklst_struct *src);
+	static void lock_pair(struct lnklst_struct *a, struct lnklst_struct *b);
+	static void unlock_pair(struct lnklst_struct *a, struct lnklst_struct *b);
+	static struct header_struct* retire_chain(struct lnklst_struct *lst, struct header_struct *chain);
+	static void free_chain(struct lnklst_struct *lst, struct header_struct *chain);
+	#ifdef LNKLST_EPOCH
+	static void epoch_advance(struct lnklst_struct *lst);
+	#endif
+	static bool pop_node(struct lnklst_struct *lst, struct header_struct *target, void *dst, size_t size);
+	static struct header_struct* seek_index(struct lnklst_struct *lst, int index);
+	#ifdef lnklst_cond_t
+	static int64_t queue_deadline(int timeout_ms);
+	static bool queue_wait(struct lnklst_struct *lst, lnklst_cond_t *cond, int *waiting, int64_t deadline);
+	static void queue_wake(lnklst_cond_t *cond, int waiting, int count);
+	static void queue_wake_all(lnklst_cond_t *cond, int waiting);
+	#endif
+	static void sort_list(struct lnklst_struct *lst, int(*swapfunc)(void*, void*));
+	static struct header_struct* sort_chain(struct header_struct *chain, int(*swapfunc)(void*, void*));
+	static void sort_pointers(void **array, void **scratch, int count, int(*swapfunc)(void*, void*));
+	static struct header_struct* detach_chain(struct lnklst_struct *lst);
+	static void relink_chain(struct lnklst_struct *lst, struct header_struct *chain);
+	static void relink_array(struct lnklst_struct *lst, void **allocations, int count);
+	static struct header_struct* merge_chains(struct header_struct *a, struct header_struct *b, int(*swapfunc)(void*, void*));
+	static inline bool heap_before(struct heap_entry_struct *a, struct heap_entry_struct *b, int(*swapfunc)(void*, void*));
+	static void heap_down(struct heap_entry_struct *heap, int count, int i, int(*swapfunc)(void*, void*), bool latest_first);
+	static bool merge_source(struct lnklst_struct *dst, struct lnklst_struct **srcs, int i);
+	static int select_first(struct lnklst_struct *lst, int k, int(*swapfunc)(void*, void*), struct heap_entry_struct *heap);
+	static struct lru_entry_struct** lru_find(struct lnklst_lru_struct *lru, void *key, uint32_t hash);
+	static void lru_remove(struct lnklst_lru_struct *lru, struct lru_entry_struct **link);
+	static void lru_grow(struct lnklst_lru_struct *lru);
+	static struct header_struct* unrolled_find(struct lnklst_unrolled_struct *lst, void *element);
+	static bool unrolled_contains(struct lnklst_unrolled_struct *lst, struct header_struct *block, void *element);
+	static struct header_struct* unrolled_seek(struct lnklst_unrolled_struct *lst, int index);
+	static uint64_t image_hash(uint64_t hash, const void *data, size_t len);
+	static bool image_valid(const struct lnklst_map_struct *image);
+	static struct shm_block_struct* shm_alloc(struct lnklst_shm_struct *shm, size_t size);
+	static void shm_release(struct lnklst_shm_struct *shm, struct shm_block_struct *block);
+	static void shm_link_last(struct lnklst_shm_struct *shm, struct shm_block_struct *block);
+	static void shm_remove(struct lnklst_shm_struct *shm, struct shm_block_struct *block);
+	static void* arena_alloc(size_t size, void *ctx);
+	static void* arena_realloc(void *ptr, size_t size, void *ctx);
+	static void arena_free(void *ptr, void *ctx);
+	static struct arena_chunk_struct* arena_new_chunk(struct lnklst_arena_struct *arena, size_t size, int node);
+	static void arena_release_chunk(struct lnklst_arena_struct *arena, struct arena_chunk_struct *chunk);
+	static int arena_nodes(void);
+	static int arena_node(struct lnklst_arena_struct *arena);
+	static void* chunk_alloc(size_t size, int node);
+	static void chunk_free(void *ptr, size_t size);
+	static int split_segments(struct lnklst_struct *lst, struct parallel_segment_struct *segments, int count);
+	static void run_segments(struct parallel_segment_struct *segments, int count);
+	static void* run_segment(void *arg);
+	static void parallel_foreach(struct lnklst_struct *lst, struct lnklst_pool_struct *pool, void(*fn)(void*, void*), void *ctx, int nsegments);
+	static void parallel_reduce(struct lnklst_struct *lst, struct lnklst_pool_struct *pool, void(*map)(void*, void*), void(*combine)(void*, void*), const void *identity, void *result, size_t size, int nsegments);
+	static int parallel_run(struct lnklst_struct *lst, struct lnklst_pool_struct *pool, struct parallel_segment_struct *segments, int nsegments);
+	#ifdef POOL_THREADS
+	static void pool_run(struct lnklst_pool_struct *pool, struct parallel_segment_struct *segments, int count);
+	static void* pool_worker(void *arg);
+	static void pool_work(struct lnklst_pool_struct *pool, int self);
+	static int pool_take(struct lnklst_pool_struct *pool, int self);
+	#endif
+
+//********************************************************************************************************
+// Public functions
+//********************************************************************************************************
+
+const size_t lnklst_header_size = offsetof(struct header_struct, allocation);
+
+struct lnklst_struct* lnklst_create(void)
+{
+	return lnklst_create_with_allocator(NULL);
+}
+
+struct lnklst_struct* lnklst_create_with_allocator(const struct lnklst_allocator *allocator)
+{
+	struct lnklst_struct *retval;
+
+	if(allocator)
+		retval = allocator->alloc(sizeof(struct lnklst_struct), allocator->ctx);
+	else
+		retval = lnklst_platform_alloc(sizeof(struct lnklst_struct));
+
+	//only if the allocator could provide it
+	if(retval)
+	{
+		retval->allocator = allocator;
+		retval->head.before = NULL;	//last
+		retval->head.after  = NULL;	//first
+		retval->count        = 0;
+		retval->finger       = NULL;
+		retval->sorted_by    = NULL;
+		retval->sorted_count = 0;
+		#ifdef LNKLST_EPOCH
+		retval->epoch = 0;
+		retval->readers[0] = 0;
+		retval->readers[1] = 0;
+		retval->limbo[0] = NULL;
+		retval->limbo[1] = NULL;
+		#endif
+		#ifdef lnklst_mutex_t
+		lnklst_mutex_init(&retval->mutex);
+		#endif
+		#ifdef lnklst_cond_t
+		lnklst_cond_init(&retval->not_empty);
+		lnklst_cond_init(&retval->not_full);
+		retval->capacity = 0;
+		retval->waiting_pop = 0;
+		retval->waiting_push = 0;
+		retval->closed = false;
+		#endif
+	};
+
+	return retval;
+}
+
+void* lnklst_allocate(struct lnklst_struct *lst, size_t size)
+{
+	struct header_struct *new_entry;
+	void* retval = NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		//allocate new entry
+		new_entry = new_node(lst, size);
+
+		//add new entry to list
+		link_last(lst, new_entry);
+		#ifdef lnklst_cond_t
+		queue_wake(&lst->not_empty, lst->waiting_pop, 1);
+		#endif
+		retval = &new_entry->allocation;
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_allocate_aligned(struct lnklst_struct *lst, size_t size, size_t alignment)
+{
+	struct header_struct *new_entry;
+	void* retval = NULL;
+
+	if(lst && alignment && !(alignment & (alignment - 1)) && alignment <= LNKLST_MAX_ALIGNMENT)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		new_entry = new_node_aligned(lst, size, alignment);
+		link_last(lst, new_entry);
+		#ifdef lnklst_cond_t
+		queue_wake(&lst->not_empty, lst->waiting_pop, 1);
+		#endif
+		retval = &new_entry->allocation;
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_reallocate(struct lnklst_struct *lst, void* allocation, size_t size)
+{
+	struct header_struct  *target;
+	struct header_struct  *new_entry;
+	void* retval = NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		target = container_of(allocation, struct header_struct, allocation);
+		if(lst->finger == target)
+			lst->finger = NULL;
+
+		#ifndef LNKLST_EPOCH
+		if(!target->alignment && !target->slab)
+		{
+			target = node_realloc(lst, target, sizeof(struct header_struct) + size);
+			target->size = size;
+			//update the *before link in the header after this one
+			target->after->before = target;
+			//if there was a header before this one
+			if(target->before)
+				//update the *after link in the header before this one
+				target->before->after = target;
+			else
+				lst->head.after = target;
+		}
+		else
+		#endif
+		{
+			//readers may still be looking at the old allocation (LNKLST_EPOCH), realloc() would not keep an aligned allocation aligned
+			//and can't resize part of a slab, so copy it rather than move it
+			new_entry = new_node_aligned(lst, size, target->alignment);
+			memcpy(&new_entry->allocation, &target->allocation, size < target->size ? size : target->size);
+			replace_node(lst, target, new_entry);
+			chain_next(target) = NULL;
+			free_chain(lst, retire_chain(lst, target));
+			target = new_entry;
+		};
+		retval = &target->allocation;
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+	return retval;
+}
+
+void lnklst_free(struct lnklst_struct *lst, void* allocation)
+{
+	struct header_struct  *target;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		target = container_of(allocation, struct header_struct, allocation);
+		unlink_node(lst, target);
+		#ifdef lnklst_cond_t
+		queue_wake(&lst->not_full, lst->waiting_push, 1);
+		#endif
+		chain_next(target) = NULL;
+		free_chain(lst, retire_chain(lst, target));
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+}
+
+void* lnklst_last(struct lnklst_struct *lst)
+{
+	void *retval=NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		if(lst->count)
+			retval = &lst->head.before->allocation;
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_first(struct lnklst_struct *lst)
+{
+    void* retval=NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		if(lst->count)
+			retval = &lst->head.after->allocation;
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+    return retval;
+}
+
+void* lnklst_before(struct lnklst_struct *lst, void *allocation)
+{
+	void				  *retval=NULL;
+	struct header_struct  *header;
+
+	if(lst && allocation)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		header = container_of(allocation, struct header_struct, allocation);
+
+		if(header->before)		//if there was an allocation before this one
+		{
+			header = header->before;		//point to it
+			retval = &header->allocation;	//and return it's allocation
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_after(struct lnklst_struct *lst, void *allocation)
+{
+	void				  *retval=NULL;
+	struct header_struct  *header;
+
+	if(lst && allocation)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		header = container_of(allocation, struct header_struct, allocation);
+
+		if(header->after && (header->after != &lst->head))	    //if there was an allocation after this one
+		{
+			header = header->after;		    //point to it
+			retval = &header->allocation;	//and return it's allocation
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_destroy(struct lnklst_struct **lst)
+{
+	struct header_struct  *hop;
+	struct header_struct  *ahead;
+
+	if(lst && *lst)
+	{
+		lnklst_mutex_lock(&(*lst)->mutex);
+		ahead = prefetch_ahead(*lst, (*lst)->head.before, LNKLST_PREFETCH_DISTANCE, false);
+		// while the head still points at something
+		while((*lst)->head.before)
+		{
+			ahead = prefetch_ahead(*lst, ahead, 1, false);
+			hop = (*lst)->head.before->before;
+			release_node(*lst, (*lst)->head.before);
+			(*lst)->head.before = hop;
+		};
+		#ifdef LNKLST_EPOCH
+		free_chain(*lst, (*lst)->limbo[0]);
+		free_chain(*lst, (*lst)->limbo[1]);
+		#endif
+		lnklst_mutex_unlock(&(*lst)->mutex);
+		lnklst_mutex_destroy(&(*lst)->mutex);
+		#ifdef lnklst_cond_t
+		lnklst_cond_destroy(&(*lst)->not_empty);
+		lnklst_cond_destroy(&(*lst)->not_full);
+		#endif
+        // free the list itself
+        node_free(*lst, *lst);
+		*lst = NULL;
+	};
+}
+
+void lnklst_destroy_async(struct lnklst_struct **lst, struct lnklst_struct *reclaim)
+{
+	#ifdef LNKLST_EPOCH
+	struct header_struct *x;
+	int slot;
+	#endif
+
+	//reclaim can only free allocations made by its own allocator, others are freed now
+	if(lst && *lst && reclaim && *lst != reclaim && (*lst)->allocator != reclaim->allocator)
+		lnklst_destroy(lst);
+	else if(lst && *lst && reclaim && *lst != reclaim)
+	{
+		lock_pair(*lst, reclaim);
+		splice_last(reclaim, *lst);
+		#ifdef LNKLST_EPOCH
+		//as do allocations still waiting for readers, which must all have left by now
+		for(slot = 0; slot < 2; slot++)
+		{
+			while((x = (*lst)->limbo[slot]))
+			{
+				(*lst)->limbo[slot] = x->retired;
+				link_last(reclaim, x);
+			};
+		};
+		#endif
+		unlock_pair(*lst, reclaim);
+		lnklst_mutex_destroy(&(*lst)->mutex);
+		#ifdef lnklst_cond_t
+		lnklst_cond_destroy(&(*lst)->not_empty);
+		lnklst_cond_destroy(&(*lst)->not_full);
+		#endif
+		node_free(*lst, *lst);
+		*lst = NULL;
+	};
+}
+
+int lnklst_reclaim_step(struct lnklst_struct *reclaim, int budget)
+{
+	struct header_struct *x;
+	struct header_struct *removed = NULL;	//chained through chain_next()
+	int retval = 0;
+
+	if(reclaim)
+	{
+		lnklst_mutex_lock(&reclaim->mutex);
+		while(budget-- > 0 && reclaim->count)
+		{
+			x = reclaim->head.after;
+			unlink_node(reclaim, x);
+			chain_next(x) = removed;
+			removed = x;
+		};
+		retval = reclaim->count;
+		removed = retire_chain(reclaim, removed);
+		lnklst_mutex_unlock(&reclaim->mutex);
+
+		free_chain(reclaim, removed);
+	};
+
+	return retval;
+}
+
+void lnklst_sort(struct lnklst_struct *lst, int(*swapfunc)(void*, void*))
+{
+    if(lst && swapfunc)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		lst->finger = NULL;
+		if(lst->count >1)
+			sort_list(lst, swapfunc);
+		lst->sorted_by = swapfunc;
+		lst->sorted_count = lst->count;
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+}
+
+void lnklst_mark_unsorted(struct lnklst_struct *lst)
+{
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		lst->sorted_count = 0;
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+}
+
+void lnklst_merge_sorted(struct lnklst_struct *dst, struct lnklst_struct *src, int(*swapfunc)(void*, void*))
+{
+	int moved;
+
+	if(dst && src && dst != src && swapfunc && dst->allocator == src->allocator)
+	{
+		lock_pair(src, dst);
+		moved = src->count;
+		if(moved)
+		{
+			relink_chain(dst, merge_chains(detach_chain(dst), detach_chain(src), swapfunc));
+			dst->count += moved;
+			src->count = 0;
+			dst->sorted_by = swapfunc;
+			dst->sorted_count = dst->count;
+			#ifdef lnklst_cond_t
+			queue_wake(&dst->not_empty, dst->waiting_pop, moved);
+			queue_wake(&src->not_full, src->waiting_push, moved);
+			#endif
+		};
+		unlock_pair(src, dst);
+	};
+}
+
+void lnklst_merge_sorted_many(struct lnklst_struct *dst, struct lnklst_struct **srcs, int count, int(*swapfunc)(void*, void*))
+{
+	struct heap_entry_struct *heap;
+	struct lnklst_struct **locked;
+	struct lnklst_struct *lst;
+	struct header_struct *first = NULL;
+	struct header_struct *last = NULL;
+	int runs = 0;
+	int moved = 0;
+	int lists = 0;
+	int i, j;
+
+	if(dst && srcs && count > 0 && swapfunc)
+	{
+		//the heap, followed by the lists to lock
+		heap = lnklst_platform_alloc((count + 1) * (sizeof(struct heap_entry_struct) + sizeof(struct lnklst_struct*)));
+		locked = (struct lnklst_struct**)(heap + count + 1);
+
+		//lock in address order, so that merges sharing lists in other roles can't deadlock
+		for(i = -1; i < count; i++)
+		{
+			if(i < 0 || merge_source(dst, srcs, i))
+			{
+				lst = i < 0 ? dst : srcs[i];
+				for(j = lists++; j > 0 && (uintptr_t)locked[j - 1] > (uintptr_t)lst; j--)
+					locked[j] = locked[j - 1];
+				locked[j] = lst;
+			};
+		};
+		for(j = 0; j < lists; j++)
+			lnklst_mutex_lock(&locked[j]->mutex);
+
+		//one run per non empty list, dst first so that it wins ties
+		for(i = -1; i < count; i++)
+		{
+			if(i < 0 || (merge_source(dst, srcs, i) && srcs[i]->count))
+			{
+				heap[runs].node = detach_chain(i < 0 ? dst : srcs[i]);
+				heap[runs].order = i;
+				if(i >= 0)
+				{
+					moved += srcs[i]->count;
+					#ifdef lnklst_cond_t
+					queue_wake(&srcs[i]->not_full, srcs[i]->waiting_push, srcs[i]->count);
+					#endif
+					srcs[i]->count = 0;
+				};
+				if(heap[runs].node)
+					runs++;
+			};
+		};
+		for(i = runs / 2 - 1; i >= 0; i--)
+			heap_down(heap, runs, i, swapfunc, false);
+
+		//take the smallest head of all the runs, until every run is exhausted
+		while(runs)
+		{
+			if(last)
+				last->after = heap[0].node;
+			else
+				first = heap[0].node;
+			last = heap[0].node;
+			heap[0].node = last->after;
+			if(!heap[0].node)
+				heap[0] = heap[--runs];
+			heap_down(heap, runs, 0, swapfunc, false);
+		};
+
+		relink_chain(dst, first);
+		dst->count += moved;
+		dst->sorted_by = swapfunc;
+		dst->sorted_count = dst->count;
+		#ifdef lnklst_cond_t
+		queue_wake(&dst->not_empty, dst->waiting_pop, moved);
+		#endif
+
+		for(j = lists - 1; j >= 0; j--)
+			lnklst_mutex_unlock(&locked[j]->mutex);
+		lnklst_platform_free(heap);
+	};
+}
+
+int lnklst_top_k(struct lnklst_struct *lst, int k, int(*swapfunc)(void*, void*), void **allocations)
+{
+	struct heap_entry_struct *heap;
+	int retval = 0;
+	int i;
+
+	if(lst && swapfunc && allocations && k > 0)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		if(k > lst->count)
+			k = lst->count;
+		if(k)
+		{
+			heap = lnklst_platform_alloc(k * sizeof(struct heap_entry_struct));
+			retval = select_first(lst, k, swapfunc, heap);
+			for(i = 0; i < retval; i++)
+				allocations[i] = &heap[i].node->allocation;
+			lnklst_platform_free(heap);
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_partial_sort(struct lnklst_struct *lst, int k, int(*swapfunc)(void*, void*))
+{
+	struct heap_entry_struct *heap;
+	int count;
+
+	if(lst && swapfunc && k > 0)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		if(k > lst->count)
+			k = lst->count;
+		if(k)
+		{
+			heap = lnklst_platform_alloc(k * sizeof(struct heap_entry_struct));
+			count = select_first(lst, k, swapfunc, heap);
+			//move them to the front, last first
+			while(count--)
+			{
+				unlink_node(lst, heap[count].node);
+				link_first(lst, heap[count].node);
+			};
+			lst->finger = NULL;
+			lst->sorted_by = swapfunc;
+			lst->sorted_count = k;
+			lnklst_platform_free(heap);
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+}
+
+int lnklst_count(struct lnklst_struct *lst)
+{
+	int retval = 0;
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		retval = lst->count;
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+    return retval;
+}
+
+void* lnklst_index(struct lnklst_struct *lst, int index)
+{
+    void* retval=NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		if(0 <= index && index < lst->count)
+			retval = &seek_index(lst, index)->allocation;
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+    return retval;
+}
+
+void* lnklst_push_back(struct lnklst_struct *lst, const void *src, size_t size)
+{
+	struct header_struct *new_entry;
+	void* retval = NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		new_entry = new_node(lst, size);
+		if(new_entry)
+		{
+			if(src)
+				memcpy(&new_entry->allocation, src, size);
+			link_last(lst, new_entry);
+			#ifdef lnklst_cond_t
+			queue_wake(&lst->not_empty, lst->waiting_pop, 1);
+			#endif
+			retval = &new_entry->allocation;
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_push_front(struct lnklst_struct *lst, const void *src, size_t size)
+{
+	struct header_struct *new_entry;
+	void* retval = NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		new_entry = new_node(lst, size);
+		if(new_entry)
+		{
+			if(src)
+				memcpy(&new_entry->allocation, src, size);
+			link_first(lst, new_entry);
+			#ifdef lnklst_cond_t
+			queue_wake(&lst->not_empty, lst->waiting_pop, 1);
+			#endif
+			retval = &new_entry->allocation;
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+bool lnklst_pop_front(struct lnklst_struct *lst, void *dst, size_t size)
+{
+	bool retval = false;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		retval = pop_node(lst, lst->head.after, dst, size);
+		#ifdef lnklst_cond_t
+		queue_wake(&lst->not_full, lst->waiting_push, retval);
+		#endif
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+bool lnklst_pop_back(struct lnklst_struct *lst, void *dst, size_t size)
+{
+	bool retval = false;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		retval = pop_node(lst, lst->head.before, dst, size);
+		#ifdef lnklst_cond_t
+		queue_wake(&lst->not_full, lst->waiting_push, retval);
+		#endif
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+bool lnklst_peek_front(struct lnklst_struct *lst, void *dst, size_t size)
+{
+	bool retval = false;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		if(lst->count)
+		{
+			if(dst)
+				memcpy(dst, &lst->head.after->allocation, size);
+			retval = true;
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+bool lnklst_peek_back(struct lnklst_struct *lst, void *dst, size_t size)
+{
+	bool retval = false;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		if(lst->count)
+		{
+			if(dst)
+				memcpy(dst, &lst->head.before->allocation, size);
+			retval = true;
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_compact(struct lnklst_struct *lst, void(*relocfunc)(void*, void*, void*), void *ctx)
+{
+	struct header_struct *x;
+	struct header_struct *y;
+	struct header_struct *old = NULL;	//chained through chain_next()
+	struct header_struct *ahead;
+	struct compact_slab_struct *slab = NULL;
+	size_t remaining = 0;	//footprint of the nodes not yet copied
+	size_t used = 0;
+	size_t room = 0;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		for(x = lst->head.after; x && x != &lst->head; x = x->after)
+			remaining += slab_footprint(x);
+
+		//copy the nodes one after another into as few slabs as will hold them, before freeing any of the old
+		x = lst->head.after;
+		ahead = prefetch_ahead(lst, x, LNKLST_PREFETCH_DISTANCE, true);
+		while(x && x != &lst->head)
+		{
+			ahead = prefetch_ahead(lst, ahead, 1, true);
+			if(!slab || room - used < slab_footprint(x))
+			{
+				room = remaining < COMPACT_SLAB_SIZE ? remaining : COMPACT_SLAB_SIZE;
+				if(room < slab_footprint(x))
+					room = slab_footprint(x);
+				room += sizeof(struct compact_slab_struct);
+				slab = node_alloc(lst, room);
+				slab->live = 0;
+				used = sizeof(struct compact_slab_struct);
+			};
+			remaining -= slab_footprint(x);
+			y = slab_carve(slab, &used, x);
+			memcpy(&y->allocation, &x->allocation, x->size);
+			replace_node(lst, x, y);
+			if(relocfunc)
+				relocfunc(&x->allocation, &y->allocation, ctx);
+			chain_next(x) = old;
+			old = x;
+			x = y->after;
+		};
+		old = retire_chain(lst, old);
+		lnklst_mutex_unlock(&lst->mutex);
+
+		free_chain(lst, old);
+	};
+}
+
+struct lnklst_struct* lnklst_detach_all(struct lnklst_struct *lst)
+{
+	struct lnklst_struct *retval = NULL;
+
+	if(lst)
+	{
+		retval = lnklst_create_with_allocator(lst->allocator);
+		lnklst_mutex_lock(&lst->mutex);
+		if(lst->count)
+		{
+			splice_last(retval, lst);
+			#ifdef lnklst_cond_t
+			queue_wake_all(&lst->not_full, lst->waiting_push);
+			#endif
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+int lnklst_remove_if(struct lnklst_struct *lst, bool(*pred)(void*, void*), void *ctx)
+{
+	struct header_struct *x;
+	struct header_struct *next;
+	struct header_struct *removed = NULL;	//chained through chain_next()
+	struct header_struct *ahead;
+	int retval = 0;
+
+	if(lst && pred)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		x = lst->head.after;
+		ahead = prefetch_ahead(lst, x, LNKLST_PREFETCH_DISTANCE, true);
+		while(x && x != &lst->head)
+		{
+			ahead = prefetch_ahead(lst, ahead, 1, true);
+			next = x->after;
+			if(pred(&x->allocation, ctx))
+			{
+				unlink_node(lst, x);
+				chain_next(x) = removed;
+				removed = x;
+				retval++;
+			};
+			x = next;
+		};
+		#ifdef lnklst_cond_t
+		queue_wake(&lst->not_full, lst->waiting_push, retval);
+		#endif
+		removed = retire_chain(lst, removed);
+		lnklst_mutex_unlock(&lst->mutex);
+
+		//free outside of the lock
+		free_chain(lst, removed);
+	};
+
+	return retval;
+}
+
+int lnklst_partition(struct lnklst_struct *src, struct lnklst_struct *dst, bool(*pred)(void*, void*), void *ctx)
+{
+	struct header_struct *x;
+	struct header_struct *next;
+	struct header_struct *ahead;
+	int retval = 0;
+
+	if(src && dst && src != dst && pred && src->allocator == dst->allocator)
+	{
+		lock_pair(src, dst);
+		x = src->head.after;
+		ahead = prefetch_ahead(src, x, LNKLST_PREFETCH_DISTANCE, true);
+		while(x && x != &src->head)
+		{
+			ahead = prefetch_ahead(src, ahead, 1, true);
+			next = x->after;
+			if(pred(&x->allocation, ctx))
+			{
+				unlink_node(src, x);
+				link_last(dst, x);
+				retval++;
+			};
+			x = next;
+		};
+		#ifdef lnklst_cond_t
+		queue_wake(&dst->not_empty, dst->waiting_pop, retval);
+		queue_wake(&src->not_full, src->waiting_push, retval);
+		#endif
+		unlock_pair(src, dst);
+	};
+
+	return retval;
+}
+
+void* lnklst_find(struct lnklst_struct *lst, bool(*pred)(void*, void*), void *ctx)
+{
+	struct header_struct *x;
+	struct header_struct *ahead;
+	void *retval = NULL;
+
+	if(lst && pred)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		x = lst->head.after;
+		ahead = prefetch_ahead(lst, x, LNKLST_PREFETCH_DISTANCE, true);
+		while(x && x != &lst->head && !retval)
+		{
+			ahead = prefetch_ahead(lst, ahead, 1, true);
+			if(pred(&x->allocation, ctx))
+				retval = &x->allocation;
+			x = x->after;
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_find_bytes(struct lnklst_struct *lst, size_t offset, const void *key, size_t keylen)
+{
+	struct header_struct *x;
+	struct header_struct *ahead;
+	const uint8_t *k = key;
+	void *retval = NULL;
+
+	if(lst && (key || !keylen))
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		x = lst->head.after;
+		ahead = prefetch_ahead(lst, x, LNKLST_PREFETCH_DISTANCE, true);
+		while(x && x != &lst->head && !retval)
+		{
+			ahead = prefetch_ahead(lst, ahead, 1, true);
+			//the first byte rules out most allocations before setting up the full comparison. Bounds are checked without adding, which could wrap
+			if(keylen <= x->size && offset <= x->size - keylen && (!keylen || (x->allocation[offset] == k[0] && bytes_equal(&x->allocation[offset], k, keylen))))
+				retval = &x->allocation;
+			x = x->after;
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+int lnklst_find_all(struct lnklst_struct *lst, bool(*pred)(void*, void*), void *ctx, void **matches, int max)
+{
+	struct header_struct *x;
+	struct header_struct *ahead;
+	int retval = 0;
+
+	if(lst && pred && (matches || max <= 0))
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		x = lst->head.after;
+		ahead = prefetch_ahead(lst, x, LNKLST_PREFETCH_DISTANCE, true);
+		while(x && x != &lst->head)
+		{
+			ahead = prefetch_ahead(lst, ahead, 1, true);
+			if(pred(&x->allocation, ctx))
+			{
+				if(retval < max)
+					matches[retval] = &x->allocation;
+				retval++;
+			};
+			x = x->after;
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+#ifdef lnklst_cond_t
+
+void lnklst_set_capacity(struct lnklst_struct *lst, int capacity)
+{
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		lst->capacity = capacity;
+		//a larger capacity may make room for waiting producers
+		queue_wake_all(&lst->not_full, lst->waiting_push);
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+}
+
+bool lnklst_push_wait(struct lnklst_struct *lst, const void *src, size_t size, int timeout_ms)
+{
+	return lnklst_push_wait_many(lst, src, size, 1, timeout_ms) == 1;
+}
+
+int lnklst_push_wait_many(struct lnklst_struct *lst, const void *src, size_t size, int count, int timeout_ms)
+{
+	struct header_struct *new_entry;
+	int64_t deadline = queue_deadline(timeout_ms);
+	bool timed_out = false;
+	int retval = 0;
+	int batch = 0;
+
+	if(lst && src)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		//capacity is checked again after every wait, even one which timed out, as room may have been made meanwhile
+		while(retval < count && !lst->closed && !(timed_out && lst->capacity && lst->count >= lst->capacity))
+		{
+			if(lst->capacity && lst->count >= lst->capacity)
+			{
+				//consumers must see what has been added so far, before waiting for them to make room
+				queue_wake(&lst->not_empty, lst->waiting_pop, batch);
+				batch = 0;
+				timed_out = !queue_wait(lst, &lst->not_full, &lst->waiting_push, deadline);
+			}
+			else
+			{
+				new_entry = new_node(lst, size);
+				memcpy(&new_entry->allocation, (const uint8_t*)src + retval * size, size);
+				link_last(lst, new_entry);
+				retval++;
+				batch++;
+			};
+		};
+		queue_wake(&lst->not_empty, lst->waiting_pop, batch);
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+bool lnklst_pop_wait(struct lnklst_struct *lst, void *dst, size_t size, int timeout_ms)
+{
+	return lnklst_pop_wait_many(lst, dst, size, 1, timeout_ms) == 1;
+}
+
+int lnklst_pop_wait_many(struct lnklst_struct *lst, void *dst, size_t size, int max, int timeout_ms)
+{
+	int64_t deadline = queue_deadline(timeout_ms);
+	int retval = 0;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		while(!lst->count && !lst->closed)
+		{
+			if(!queue_wait(lst, &lst->not_empty, &lst->waiting_pop, deadline))
+				break;
+		};
+		while(retval < max && lst->count)
+		{
+			pop_node(lst, lst->head.after, dst ? (uint8_t*)dst + retval * size : NULL, size);
+			retval++;
+		};
+		queue_wake(&lst->not_full, lst->waiting_push, retval);
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_close(struct lnklst_struct *lst)
+{
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		lst->closed = true;
+		queue_wake_all(&lst->not_empty, lst->waiting_pop);
+		queue_wake_all(&lst->not_full, lst->waiting_push);
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+}
+
+#endif
+
+struct lnklst_lru_struct* lnklst_lru_create(int max_count, size_t max_bytes, void*(*keyfunc)(void*), uint32_t(*hashfunc)(void*), int(*keycmp)(void*, void*), void(*evictfunc)(void*))
+{
+	struct lnklst_lru_struct *retval = NULL;
+
+	if(keyfunc && hashfunc && keycmp)
+	{
+		retval = lnklst_platform_alloc(sizeof(struct lnklst_lru_struct));
+		retval->lst = lnklst_create();
+		retval->bucket_count = LRU_INITIAL_BUCKETS;
+		retval->buckets = lnklst_platform_alloc(LRU_INITIAL_BUCKETS * sizeof(struct lru_entry_struct*));
+		memset(retval->buckets, 0, LRU_INITIAL_BUCKETS * sizeof(struct lru_entry_struct*));
+		retval->max_count = max_count;
+		retval->max_bytes = max_bytes;
+		retval->bytes = 0;
+		retval->keyfunc = keyfunc;
+		retval->hashfunc = hashfunc;
+		retval->keycmp = keycmp;
+		retval->evictfunc = evictfunc;
+	};
+
+	return retval;
+}
+
+void lnklst_lru_destroy(struct lnklst_lru_struct **lru)
+{
+	struct header_struct *x;
+
+	if(lru && *lru)
+	{
+		if((*lru)->evictfunc)
+		{
+			x = (*lru)->lst->head.after;
+			while(x && x != &(*lru)->lst->head)
+			{
+				(*lru)->evictfunc(((struct lru_entry_struct*)&x->allocation)->data);
+				x = x->after;
+			};
+		};
+		lnklst_destroy(&(*lru)->lst);
+		lnklst_platform_free((*lru)->buckets);
+		lnklst_platform_free((*lru));
+		*lru = NULL;
+	};
+}
+
+void* lnklst_lru_put(struct lnklst_lru_struct *lru, const void *data, size_t size)
+{
+	struct lru_entry_struct **link;
+	struct lru_entry_struct *entry;
+	struct header_struct *header;
+	uint32_t hash;
+	void *retval = NULL;
+
+	if(lru && data)
+	{
+		lnklst_mutex_lock(&lru->lst->mutex);
+		hash = lru->hashfunc(lru->keyfunc((void*)data));
+		link = lru_find(lru, lru->keyfunc((void*)data), hash);
+		if(*link)
+			lru_remove(lru, link);
+
+		header = new_node(lru->lst, sizeof(struct lru_entry_struct) + size);
+		link_last(lru->lst, header);
+		entry = (struct lru_entry_struct*)&header->allocation;
+		entry->size = size;
+		entry->hash = hash;
+		memcpy(entry->data, data, size);
+		entry->next = lru->buckets[hash & (lru->bucket_count - 1)];
+		lru->buckets[hash & (lru->bucket_count - 1)] = entry;
+		lru->bytes += size;
+
+		//evict from the least recently used end, but never the new entry
+		while(lru->lst->count > 1 && ((lru->max_count && lru->lst->count > lru->max_count) || (lru->max_bytes && lru->bytes > lru->max_bytes)))
+		{
+			entry = (struct lru_entry_struct*)&lru->lst->head.after->allocation;
+			lru_remove(lru, lru_find(lru, lru->keyfunc(entry->data), entry->hash));
+		};
+
+		if((uint32_t)lru->lst->count > lru->bucket_count)
+			lru_grow(lru);
+
+		retval = ((struct lru_entry_struct*)&header->allocation)->data;
+		lnklst_mutex_unlock(&lru->lst->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_lru_get(struct lnklst_lru_struct *lru, void *key)
+{
+	struct lru_entry_struct *entry;
+	struct header_struct *header;
+	void *retval = NULL;
+
+	if(lru && key)
+	{
+		lnklst_mutex_lock(&lru->lst->mutex);
+		entry = *lru_find(lru, key, lru->hashfunc(key));
+		if(entry)
+		{
+			//move to the most recently used end
+			header = container_of(entry, struct header_struct, allocation);
+			unlink_node(lru->lst, header);
+			link_last(lru->lst, header);
+			retval = entry->data;
+		};
+		lnklst_mutex_unlock(&lru->lst->mutex);
+	};
+
+	return retval;
+}
+
+bool lnklst_lru_evict(struct lnklst_lru_struct *lru, void *key)
+{
+	struct lru_entry_struct **link;
+	bool retval = false;
+
+	if(lru && key)
+	{
+		lnklst_mutex_lock(&lru->lst->mutex);
+		link = lru_find(lru, key, lru->hashfunc(key));
+		if(*link)
+		{
+			lru_remove(lru, link);
+			retval = true;
+		};
+		lnklst_mutex_unlock(&lru->lst->mutex);
+	};
+
+	return retval;
+}
+
+int lnklst_lru_count(struct lnklst_lru_struct *lru)
+{
+	int retval = 0;
+	if(lru)
+		retval = lnklst_count(lru->lst);
+	return retval;
+}
+
+struct lnklst_unrolled_struct* lnklst_create_unrolled(size_t elem_size, int elems_per_block)
+{
+	struct lnklst_unrolled_struct *retval = NULL;
+
+	if(elem_size && elems_per_block > 0)
+	{
+		retval = lnklst_platform_alloc(sizeof(struct lnklst_unrolled_struct));
+		retval->blocks = lnklst_create();
+		retval->elem_size = elem_size;
+		retval->elems_per_block = elems_per_block;
+		retval->count = 0;
+		retval->finger = NULL;
+	};
+
+	return retval;
+}
+
+void lnklst_unrolled_destroy(struct lnklst_unrolled_struct **lst)
+{
+	if(lst && *lst)
+	{
+		lnklst_destroy(&(*lst)->blocks);
+		lnklst_platform_free((*lst));
+		*lst = NULL;
+	};
+}
+
+void* lnklst_unrolled_allocate(struct lnklst_unrolled_struct *lst)
+{
+	struct header_struct *last;
+	void *retval = NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->blocks->mutex);
+		last = lst->blocks->head.before;
+		if(!last || block_of(last)->used == lst->elems_per_block)
+		{
+			last = new_node(lst->blocks, sizeof(struct unrolled_block_struct) + lst->elem_size * lst->elems_per_block);
+			block_of(last)->used = 0;
+			link_last(lst->blocks, last);
+		};
+		retval = &block_of(last)->elements[block_of(last)->used * lst->elem_size];
+		block_of(last)->used++;
+		lst->count++;
+		lnklst_mutex_unlock(&lst->blocks->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_unrolled_free(struct lnklst_unrolled_struct *lst, void *element)
+{
+	struct header_struct *block;
+	struct unrolled_block_struct *b;
+	uint8_t *end;
+
+	if(lst && element)
+	{
+		lnklst_mutex_lock(&lst->blocks->mutex);
+		block = unrolled_find(lst, element);
+		if(block)
+		{
+			b = block_of(block);
+			end = &b->elements[b->used * lst->elem_size];
+			memmove(element, (uint8_t*)element + lst->elem_size, end - ((uint8_t*)element + lst->elem_size));
+			b->used--;
+			lst->count--;
+			//the finger only knows the index of the block it's in
+			if(lst->finger != block)
+				lst->finger = NULL;
+			if(!b->used)
+			{
+				lst->finger = NULL;
+				unlink_node(lst->blocks, block);
+				release_node(lst->blocks, block);
+			};
+		};
+		lnklst_mutex_unlock(&lst->blocks->mutex);
+	};
+}
+
+void* lnklst_unrolled_before(struct lnklst_unrolled_struct *lst, void *element)
+{
+	struct header_struct *block;
+	void *retval = NULL;
+
+	if(lst && element)
+	{
+		lnklst_mutex_lock(&lst->blocks->mutex);
+		block = unrolled_find(lst, element);
+		if(block)
+		{
+			if(element != block_of(block)->elements)
+				retval = (uint8_t*)element - lst->elem_size;
+			else if(block->before)
+				retval = &block_of(block->before)->elements[(block_of(block->before)->used - 1) * lst->elem_size];
+		};
+		lnklst_mutex_unlock(&lst->blocks->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_unrolled_after(struct lnklst_unrolled_struct *lst, void *element)
+{
+	struct header_struct *block;
+	void *retval = NULL;
+
+	if(lst && element)
+	{
+		lnklst_mutex_lock(&lst->blocks->mutex);
+		block = unrolled_find(lst, element);
+		if(block)
+		{
+			if((uint8_t*)element + lst->elem_size != &block_of(block)->elements[block_of(block)->used * lst->elem_size])
+				retval = (uint8_t*)element + lst->elem_size;
+			else if(block->after != &lst->blocks->head)
+				retval = block_of(block->after)->elements;
+		};
+		lnklst_mutex_unlock(&lst->blocks->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_unrolled_first(struct lnklst_unrolled_struct *lst)
+{
+	void *retval = NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->blocks->mutex);
+		if(lst->count)
+			retval = block_of(lst->blocks->head.after)->elements;
+		lnklst_mutex_unlock(&lst->blocks->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_unrolled_last(struct lnklst_unrolled_struct *lst)
+{
+	struct unrolled_block_struct *b;
+	void *retval = NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->blocks->mutex);
+		if(lst->count)
+		{
+			b = block_of(lst->blocks->head.before);
+			retval = &b->elements[(b->used - 1) * lst->elem_size];
+		};
+		lnklst_mutex_unlock(&lst->blocks->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_unrolled_index(struct lnklst_unrolled_struct *lst, int index)
+{
+	struct header_struct *block;
+	void *retval = NULL;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->blocks->mutex);
+		if(0 <= index && index < lst->count)
+		{
+			block = unrolled_seek(lst, index);
+			retval = &block_of(block)->elements[(index - lst->finger_index) * lst->elem_size];
+		};
+		lnklst_mutex_unlock(&lst->blocks->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_unrolled_sort(struct lnklst_unrolled_struct *lst, int(*swapfunc)(void*, void*))
+{
+	struct header_struct *x;
+	uint8_t *all;
+	uint8_t *pos;
+	void **order;
+	size_t size;
+	int i;
+
+	if(lst && swapfunc)
+	{
+		lnklst_mutex_lock(&lst->blocks->mutex);
+		if(lst->count > 1)
+		{
+			//sort pointers to the elements where they are, gather the elements in that order, then scatter them back into the same blocks
+			size = (lst->count * lst->elem_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+			all = lnklst_platform_alloc(size + 2 * lst->count * sizeof(void*));
+			order = (void**)(all + size);
+			i = 0;
+			for(x = lst->blocks->head.after; x != &lst->blocks->head; x = x->after)
+			{
+				for(pos = block_of(x)->elements; pos < block_of(x)->elements + block_of(x)->used * lst->elem_size; pos += lst->elem_size)
+					order[i++] = pos;
+			};
+			sort_pointers(order, order + lst->count, lst->count, swapfunc);
+			for(i = 0; i < lst->count; i++)
+				memcpy(all + i * lst->elem_size, order[i], lst->elem_size);
+			pos = all;
+			for(x = lst->blocks->head.after; x != &lst->blocks->head; x = x->after)
+			{
+				size = block_of(x)->used * lst->elem_size;
+				memcpy(block_of(x)->elements, pos, size);
+				pos += size;
+			};
+			lnklst_platform_free(all);
+		};
+		lnklst_mutex_unlock(&lst->blocks->mutex);
+	};
+}
+
+int lnklst_unrolled_count(struct lnklst_unrolled_struct *lst)
+{
+	int retval = 0;
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->blocks->mutex);
+		retval = lst->count;
+		lnklst_mutex_unlock(&lst->blocks->mutex);
+	};
+	return retval;
+}
+
+#ifdef LNKLST_EPOCH
+
+int lnklst_read_enter(struct lnklst_struct *lst)
+{
+	unsigned epoch = 0;
+
+	if(lst)
+	{
+		//join the current epoch's readers, unless the epoch moved on before we were counted
+		while(true)
+		{
+			epoch = __atomic_load_n(&lst->epoch, __ATOMIC_SEQ_CST);
+			__atomic_add_fetch(&lst->readers[epoch & 1], 1, __ATOMIC_SEQ_CST);
+			if(__atomic_load_n(&lst->epoch, __ATOMIC_SEQ_CST) == epoch)
+				break;
+			__atomic_sub_fetch(&lst->readers[epoch & 1], 1, __ATOMIC_SEQ_CST);
+		};
+	};
+
+	return epoch & 1;
+}
+
+void lnklst_read_exit(struct lnklst_struct *lst, int token)
+{
+	if(lst)
+		__atomic_sub_fetch(&lst->readers[token & 1], 1, __ATOMIC_SEQ_CST);
+}
+
+void* lnklst_read_first(struct lnklst_struct *lst)
+{
+	struct header_struct *header;
+	void *retval = NULL;
+
+	if(lst)
+	{
+		header = link_load(lst->head.after);
+		if(header)
+			retval = &header->allocation;
+	};
+
+	return retval;
+}
+
+void* lnklst_read_last(struct lnklst_struct *lst)
+{
+	struct header_struct *header;
+	void *retval = NULL;
+
+	if(lst)
+	{
+		header = link_load(lst->head.before);
+		if(header)
+			retval = &header->allocation;
+	};
+
+	return retval;
+}
+
+void* lnklst_read_before(struct lnklst_struct *lst, void *allocation)
+{
+	struct header_struct *header;
+	void *retval = NULL;
+
+	if(lst && allocation)
+	{
+		header = link_load(container_of(allocation, struct header_struct, allocation)->before);
+		if(header)
+			retval = &header->allocation;
+	};
+
+	return retval;
+}
+
+struct lnklst_snapshot_struct* lnklst_snapshot(struct lnklst_struct *lst)
+{
+	struct lnklst_snapshot_struct *retval = NULL;
+	struct header_struct *x;
+	void **dst;
+
+	if(lst)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		retval = lnklst_platform_alloc(sizeof(struct lnklst_snapshot_struct) + lst->count * sizeof(void*));
+		retval->lst = lst;
+		retval->count = lst->count;
+		//while locked no writer can retire anything, so no allocation we capture can be freed before this reader is counted
+		retval->token = lnklst_read_enter(lst);
+		dst = retval->allocations;
+		x = lst->head.after;
+		while(x && x != &lst->head)
+		{
+			lnklst_prefetch(x->after);
+			*dst++ = &x->allocation;
+			x = x->after;
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_snapshot_release(struct lnklst_snapshot_struct **snap)
+{
+	if(snap && *snap)
+	{
+		lnklst_read_exit((*snap)->lst, (*snap)->token);
+		lnklst_platform_free(*snap);
+		*snap = NULL;
+	};
+}
+
+int lnklst_snapshot_count(struct lnklst_snapshot_struct *snap)
+{
+	int retval = 0;
+
+	if(snap)
+		retval = snap->count;
+
+	return retval;
+}
+
+void* lnklst_snapshot_index(struct lnklst_snapshot_struct *snap, int index)
+{
+	void *retval = NULL;
+
+	if(snap && index >= 0 && index < snap->count)
+		retval = snap->allocations[index];
+
+	return retval;
+}
+
+void* lnklst_read_after(struct lnklst_struct *lst, void *allocation)
+{
+	struct header_struct *header;
+	void *retval = NULL;
+
+	if(lst && allocation)
+	{
+		header = link_load(container_of(allocation, struct header_struct, allocation)->after);
+		if(header && header != &lst->head)
+			retval = &header->allocation;
+	};
+
+	return retval;
+}
+
+#endif
+
+bool lnklst_save(struct lnklst_struct *lst, bool checksum, bool(*writefunc)(const void*, size_t, void*), void *ctx)
+{
+	static const uint8_t padding[IMAGE_ALIGN] = {0};
+	struct lnklst_map_struct image = {0};
+	struct image_record_struct record = {0};
+	struct header_struct *x;
+	uint64_t hash = IMAGE_HASH_INIT;
+	size_t pad;
+	bool retval = false;
+
+	if(lst && writefunc)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		image.magic = IMAGE_MAGIC;
+		image.version = IMAGE_VERSION;
+		image.flags = checksum ? IMAGE_CHECKSUM : 0;
+		image.count = lst->count;
+		x = lst->head.after;
+		while(x && x != &lst->head)
+		{
+			image.bytes += sizeof(struct image_record_struct) + image_round(x->size);
+			x = x->after;
+		};
+		hash = image_hash(hash, &image, sizeof(image));
+		retval = writefunc(&image, sizeof(image), ctx);
+
+		x = lst->head.after;
+		while(retval && x && x != &lst->head)
+		{
+			lnklst_prefetch(x->after);
+			record.size = x->size;
+			pad = image_round(x->size) - x->size;
+			if(checksum)
+				hash = image_hash(image_hash(hash, &record, sizeof(record)), &x->allocation, x->size);
+			retval = writefunc(&record, sizeof(record), ctx);
+			if(retval && x->size)
+				retval = writefunc(&x->allocation, x->size, ctx);
+			if(retval && pad)
+				retval = writefunc(padding, pad, ctx);
+			x = x->after;
+		};
+
+		if(retval && checksum)
+			retval = writefunc(&hash, sizeof(hash), ctx);
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+struct lnklst_struct* lnklst_load(bool(*readfunc)(void*, size_t, void*), void *ctx)
+{
+	struct lnklst_struct *retval = NULL;
+	struct lnklst_map_struct image;
+	struct image_record_struct record;
+	struct header_struct *x;
+	uint8_t padding[IMAGE_ALIGN];
+	uint64_t hash = IMAGE_HASH_INIT;
+	uint64_t stored;
+	uint64_t remaining;
+	uint32_t i;
+	size_t pad;
+	size_t have;
+	size_t want;
+	bool ok;
+
+	if(readfunc && readfunc(&image, sizeof(image), ctx) && image_valid(&image))
+	{
+		retval = lnklst_create();
+		hash = image_hash(hash, &image, sizeof(image));
+		remaining = image.bytes;
+		ok = true;
+		for(i = 0; ok && i < image.count; i++)
+		{
+			ok = remaining >= sizeof(record) && readfunc(&record, sizeof(record), ctx);
+			ok = ok && record.size <= remaining - sizeof(record) && image_round(record.size) <= remaining - sizeof(record);
+			ok = ok && record.size <= SIZE_MAX - sizeof(struct header_struct);
+			if(ok)
+			{
+				//read straight into the node, growing it as the payload arrives rather than trusting the size up front
+				want = record.size < IMAGE_LOAD_CHUNK ? record.size : IMAGE_LOAD_CHUNK;
+				x = new_node(retval, want);
+				for(have = 0; ok && have < record.size; want = (record.size - want > want) ? want * 2 : record.size)
+				{
+					if(want > x->size)
+					{
+						x = node_realloc(retval, x, sizeof(struct header_struct) + want);
+						x->size = want;
+					};
+					ok = readfunc(&x->allocation[have], want - have, ctx);
+					have = want;
+				};
+				//link it so that destroy will free it if this or a later record is bad
+				link_last(retval, x);
+				pad = image_round(record.size) - record.size;
+				if(ok && pad)
+					ok = readfunc(padding, pad, ctx);
+				if(ok && (image.flags & IMAGE_CHECKSUM))
+					hash = image_hash(image_hash(hash, &record, sizeof(record)), &x->allocation, record.size);
+				remaining -= sizeof(record) + image_round(record.size);
+			};
+		};
+
+		ok = ok && !remaining;
+		if(ok && (image.flags & IMAGE_CHECKSUM))
+			ok = readfunc(&stored, sizeof(stored), ctx) && stored == hash;
+		if(!ok)
+			lnklst_destroy(&retval);
+	};
+
+	return retval;
+}
+
+const struct lnklst_map_struct* lnklst_map(const void *image, size_t length)
+{
+	const struct lnklst_map_struct *retval = NULL;
+	const struct lnklst_map_struct *map = image;
+	const struct image_record_struct *record;
+	const uint8_t *end;
+	uint64_t hash = IMAGE_HASH_INIT;
+	uint64_t stored;
+	uint32_t i;
+	bool ok;
+
+	if(map && !((uintptr_t)image & (IMAGE_ALIGN - 1)) && length >= sizeof(*map) && image_valid(map))
+	{
+		ok = map->bytes <= length - sizeof(*map);
+		if(ok && (map->flags & IMAGE_CHECKSUM))
+			ok = sizeof(stored) <= length - sizeof(*map) - map->bytes;
+
+		//check every record lies within the image, so that the traversal functions need not
+		end = (const uint8_t*)(map + 1) + (ok ? map->bytes : 0);
+		record = (const struct image_record_struct*)(map + 1);
+		hash = image_hash(hash, map, sizeof(*map));
+		for(i = 0; ok && i < map->count; i++)
+		{
+			ok = (size_t)(end - (const uint8_t*)record) >= sizeof(*record);
+			ok = ok && record->size <= (size_t)(end - record->payload) && image_round(record->size) <= (size_t)(end - record->payload);
+			if(ok)
+			{
+				if(map->flags & IMAGE_CHECKSUM)
+					hash = image_hash(image_hash(hash, record, sizeof(*record)), record->payload, record->size);
+				record = (const struct image_record_struct*)(record->payload + image_round(record->size));
+			};
+		};
+
+		ok = ok && (const uint8_t*)record == end;
+		if(ok && (map->flags & IMAGE_CHECKSUM))
+		{
+			memcpy(&stored, end, sizeof(stored));
+			ok = stored == hash;
+		};
+		if(ok)
+			retval = map;
+	};
+
+	return retval;
+}
+
+int lnklst_map_count(const struct lnklst_map_struct *map)
+{
+	int retval = 0;
+
+	if(map)
+		retval = map->count;
+
+	return retval;
+}
+
+const void* lnklst_map_first(const struct lnklst_map_struct *map)
+{
+	const void *retval = NULL;
+
+	if(map && map->count)
+		retval = ((const struct image_record_struct*)(map + 1))->payload;
+
+	return retval;
+}
+
+const void* lnklst_map_after(const struct lnklst_map_struct *map, const void *allocation)
+{
+	const struct image_record_struct *record;
+	const void *retval = NULL;
+
+	if(map && allocation)
+	{
+		record = container_of(allocation, struct image_record_struct, payload);
+		record = (const struct image_record_struct*)(record->payload + image_round(record->size));
+		if((const uint8_t*)record < (const uint8_t*)(map + 1) + map->bytes)
+			retval = record->payload;
+	};
+
+	return retval;
+}
+
+size_t lnklst_map_size(const struct lnklst_map_struct *map, const void *allocation)
+{
+	size_t retval = 0;
+
+	if(map && allocation)
+		retval = container_of(allocation, struct image_record_struct, payload)->size;
+
+	return retval;
+}
+
+struct lnklst_shm_struct* lnklst_shm_create(void *region, size_t size)
+{
+	struct lnklst_shm_struct *retval = NULL;
+	struct shm_block_struct *block;
+
+	if(region && !((uintptr_t)region & (SHM_ALIGN - 1)) && size >= sizeof(struct lnklst_shm_struct) + sizeof(struct shm_block_struct) + SHM_ALIGN)
+	{
+		retval = region;
+		retval->count = 0;
+		retval->size = size & ~(size_t)(SHM_ALIGN - 1);
+		retval->first = 0;
+		retval->last = 0;
+		//the rest of the region is one free block
+		retval->free = sizeof(struct lnklst_shm_struct);
+		block = shm_block(retval, retval->free);
+		block->size = retval->size - sizeof(struct lnklst_shm_struct);
+		block->after = 0;
+		lnklst_mutex_init_shared(&retval->mutex);
+		retval->magic = SHM_MAGIC;
+	};
+
+	return retval;
+}
+
+struct lnklst_shm_struct* lnklst_shm_attach(void *region)
+{
+	struct lnklst_shm_struct *retval = NULL;
+
+	if(region && ((struct lnklst_shm_struct*)region)->magic == SHM_MAGIC)
+		retval = region;
+
+	return retval;
+}
+
+void lnklst_shm_destroy(struct lnklst_shm_struct *shm)
+{
+	if(shm)
+	{
+		shm->magic = 0;
+		lnklst_mutex_destroy(&shm->mutex);
+	};
+}
+
+void* lnklst_shm_allocate(struct lnklst_shm_struct *shm, size_t size)
+{
+	struct shm_block_struct *block;
+	void *retval = NULL;
+
+	if(shm)
+	{
+		lnklst_mutex_lock(&shm->mutex);
+		block = shm_alloc(shm, size);
+		if(block)
+		{
+			shm_link_last(shm, block);
+			retval = &block->allocation;
+		};
+		lnklst_mutex_unlock(&shm->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_shm_free(struct lnklst_shm_struct *shm, void *allocation)
+{
+	struct shm_block_struct *block;
+
+	if(shm && allocation)
+	{
+		lnklst_mutex_lock(&shm->mutex);
+		block = container_of(allocation, struct shm_block_struct, allocation);
+		shm_remove(shm, block);
+		shm_release(shm, block);
+		lnklst_mutex_unlock(&shm->mutex);
+	};
+}
+
+void* lnklst_shm_push_back(struct lnklst_shm_struct *shm, const void *src, size_t size)
+{
+	struct shm_block_struct *block;
+	void *retval = NULL;
+
+	if(shm && src)
+	{
+		lnklst_mutex_lock(&shm->mutex);
+		block = shm_alloc(shm, size);
+		if(block)
+		{
+			memcpy(&block->allocation, src, size);
+			shm_link_last(shm, block);
+			retval = &block->allocation;
+		};
+		lnklst_mutex_unlock(&shm->mutex);
+	};
+
+	return retval;
+}
+
+bool lnklst_shm_pop_front(struct lnklst_shm_struct *shm, void *dst, size_t size)
+{
+	struct shm_block_struct *block;
+	bool retval = false;
+
+	if(shm)
+	{
+		lnklst_mutex_lock(&shm->mutex);
+		if(shm->first)
+		{
+			block = shm_block(shm, shm->first);
+			if(dst)
+				memcpy(dst, &block->allocation, size);
+			shm_remove(shm, block);
+			shm_release(shm, block);
+			retval = true;
+		};
+		lnklst_mutex_unlock(&shm->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_shm_before(struct lnklst_shm_struct *shm, void *allocation)
+{
+	struct shm_block_struct *block;
+	void *retval = NULL;
+
+	if(shm && allocation)
+	{
+		lnklst_mutex_lock(&shm->mutex);
+		block = container_of(allocation, struct shm_block_struct, allocation);
+		if(block->before)
+			retval = &shm_block(shm, block->before)->allocation;
+		lnklst_mutex_unlock(&shm->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_shm_after(struct lnklst_shm_struct *shm, void *allocation)
+{
+	struct shm_block_struct *block;
+	void *retval = NULL;
+
+	if(shm && allocation)
+	{
+		lnklst_mutex_lock(&shm->mutex);
+		block = container_of(allocation, struct shm_block_struct, allocation);
+		if(block->after)
+			retval = &shm_block(shm, block->after)->allocation;
+		lnklst_mutex_unlock(&shm->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_shm_first(struct lnklst_shm_struct *shm)
+{
+	void *retval = NULL;
+
+	if(shm)
+	{
+		lnklst_mutex_lock(&shm->mutex);
+		if(shm->first)
+			retval = &shm_block(shm, shm->first)->allocation;
+		lnklst_mutex_unlock(&shm->mutex);
+	};
+
+	return retval;
+}
+
+void* lnklst_shm_last(struct lnklst_shm_struct *shm)
+{
+	void *retval = NULL;
+
+	if(shm)
+	{
+		lnklst_mutex_lock(&shm->mutex);
+		if(shm->last)
+			retval = &shm_block(shm, shm->last)->allocation;
+		lnklst_mutex_unlock(&shm->mutex);
+	};
+
+	return retval;
+}
+
+int lnklst_shm_count(struct lnklst_shm_struct *shm)
+{
+	int retval = 0;
+
+	if(shm)
+	{
+		lnklst_mutex_lock(&shm->mutex);
+		retval = shm->count;
+		lnklst_mutex_unlock(&shm->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_reorder(struct lnklst_struct *lst, void **allocations, int count)
+{
+	if(lst && allocations)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		if(count == lst->count && count)
+			relink_array(lst, allocations, count);
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+}
+
+int lnklst_gather(struct lnklst_struct *lst, void **allocations, int max)
+{
+	struct header_struct *x;
+	int retval = 0;
+
+	if(lst && allocations)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		x = lst->head.after;
+		while(x && x != &lst->head && retval < max)
+		{
+			lnklst_prefetch(x->after);
+			allocations[retval++] = &x->allocation;
+			x = x->after;
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_sort_gathered(struct lnklst_struct *lst, void(*sortfunc)(void**, int, void*), void *ctx)
+{
+	struct header_struct *x;
+	void **allocations;
+	int i = 0;
+
+	if(lst && sortfunc)
+	{
+		lnklst_mutex_lock(&lst->mutex);
+		if(lst->count > 1)
+		{
+			allocations = lnklst_platform_alloc(lst->count * sizeof(void*));
+			x = lst->head.after;
+			while(x != &lst->head)
+			{
+				lnklst_prefetch(x->after);
+				allocations[i++] = &x->allocation;
+				x = x->after;
+			};
+			sortfunc(allocations, lst->count, ctx);
+			relink_array(lst, allocations, lst->count);
+			lnklst_platform_free(allocations);
+		};
+		lnklst_mutex_unlock(&lst->mutex);
+	};
+}
+
+struct lnklst_arena_struct* lnklst_arena_create(size_t chunk_size)
+{
+	struct lnklst_arena_struct *retval = NULL;
+	size_t round = NODE_ALIGN;
+	int nodes = arena_nodes();
+	int i;
+
+	#if !defined(lnklst_platform_chunk_alloc) && defined(LNKLST_HUGEPAGES)
+	round = HUGE_PAGE_SIZE;
+	#endif
+	//a chunk must hold its header and at least one small allocation, or arena_alloc() would write past its end
+	if(chunk_size < ARENA_MIN_CHUNK)
+		chunk_size = ARENA_MIN_CHUNK;
+	if(chunk_size <= SIZE_MAX - round)
+	{
+		retval = lnklst_platform_alloc(sizeof(struct lnklst_arena_struct) + nodes * sizeof(struct arena_chunk_struct*));
+		retval->allocator.alloc = arena_alloc;
+		retval->allocator.realloc = arena_realloc;
+		retval->allocator.free = arena_free;
+		retval->allocator.ctx = retval;
+		retval->chunk_size = (chunk_size + round - 1) & ~(size_t)(round - 1);
+		retval->chunks = NULL;
+		retval->nodes = nodes;
+		for(i = 0; i < nodes; i++)
+			retval->current[i] = NULL;
+		lnklst_mutex_init(&retval->mutex);
+	};
+
+	return retval;
+}
+
+void lnklst_arena_destroy(struct lnklst_arena_struct **arena)
+{
+	if(arena && *arena)
+	{
+		while((*arena)->chunks)
+			arena_release_chunk(*arena, (*arena)->chunks);
+		lnklst_mutex_destroy(&(*arena)->mutex);
+		lnklst_platform_free(*arena);
+		*arena = NULL;
+	};
+}
+
+const struct lnklst_allocator* lnklst_arena_allocator(struct lnklst_arena_struct *arena)
+{
+	const struct lnklst_allocator *retval = NULL;
+
+	if(arena)
+		retval = &arena->allocator;
+
+	return retval;
+}
+
+void lnklst_parallel_foreach(struct lnklst_struct *lst, void(*fn)(void*, void*), void *ctx, int nthreads)
+{
+	#ifndef lnklst_thread_t
+	nthreads = 1;
+	#endif
+	if(lst && fn)
+		parallel_foreach(lst, NULL, fn, ctx, nthreads < 1 ? 1 : nthreads);
+}
+
+void lnklst_parallel_reduce(struct lnklst_struct *lst, void(*map)(void*, void*), void(*combine)(void*, void*), const void *identity, void *result, size_t size, int nthreads)
+{
+	#ifndef lnklst_thread_t
+	nthreads = 1;
+	#endif
+	if(lst && map && combine && identity && result)
+		parallel_reduce(lst, NULL, map, combine, identity, result, size, nthreads < 1 ? 1 : nthreads);
+}
+
+struct lnklst_pool_struct* lnklst_pool_create(int nthreads)
+{
+	struct lnklst_pool_struct *retval;
+	int i;
+
+	#ifndef POOL_THREADS
+	nthreads = 0;
+	#endif
+	if(nthreads < 0)
+		nthreads = 0;
+	retval = lnklst_platform_alloc(sizeof(struct lnklst_pool_struct) + (nthreads + 1) * sizeof(struct pool_worker_struct));
+	retval->nworkers = nthreads;
+	#ifdef POOL_THREADS
+	retval->segments = NULL;
+	retval->remaining = 0;
+	retval->busy = 0;
+	retval->generation = 0;
+	retval->stop = false;
+	lnklst_mutex_init(&retval->mutex);
+	lnklst_mutex_init(&retval->run);
+	lnklst_cond_init(&retval->work);
+	lnklst_cond_init(&retval->done);
+	//the last deque is the calling thread's
+	for(i = 0; i <= nthreads; i++)
+	{
+		retval->workers[i].pool = retval;
+		retval->workers[i].index = i;
+		retval->workers[i].top = 0;
+		retval->workers[i].bottom = 0;
+		lnklst_mutex_init(&retval->workers[i].mutex);
+	};
+	for(i = 0; i < nthreads; i++)
+		retval->workers[i].started = !lnklst_thread_create(&retval->workers[i].thread, pool_worker, &retval->workers[i]);
+	#else
+	(void)i;
+	#endif
+
+	return retval;
+}
+
+void lnklst_pool_destroy(struct lnklst_pool_struct **pool)
+{
+	#ifdef POOL_THREADS
+	int i;
+	#endif
+
+	if(pool && *pool)
+	{
+		#ifdef POOL_THREADS
+		lnklst_mutex_lock(&(*pool)->mutex);
+		(*pool)->stop = true;
+		lnklst_cond_broadcast(&(*pool)->work);
+		lnklst_mutex_unlock(&(*pool)->mutex);
+		for(i = 0; i < (*pool)->nworkers; i++)
+		{
+			if((*pool)->workers[i].started)
+				lnklst_thread_join((*pool)->workers[i].thread);
+		};
+		for(i = 0; i <= (*pool)->nworkers; i++)
+			lnklst_mutex_destroy(&(*pool)->workers[i].mutex);
+		lnklst_cond_destroy(&(*pool)->work);
+		lnklst_cond_destroy(&(*pool)->done);
+		lnklst_mutex_destroy(&(*pool)->run);
+		lnklst_mutex_destroy(&(*pool)->mutex);
+		#endif
+		lnklst_platform_free(*pool);
+		*pool = NULL;
+	};
+}
+
+void lnklst_pool_foreach(struct lnklst_pool_struct *pool, struct lnklst_struct *lst, void(*fn)(void*, void*), void *ctx)
+{
+	if(pool && lst && fn)
+		parallel_foreach(lst, pool, fn, ctx, (pool->nworkers + 1) * POOL_CHUNKS);
+}
+
+void lnklst_pool_reduce(struct lnklst_pool_struct *pool, struct lnklst_struct *lst, void(*map)(void*, void*), void(*combine)(void*, void*), const void *identity, void *result, size_t size)
+{
+	if(pool && lst && map && combine && identity && result)
+		parallel_reduce(lst, pool, map, combine, identity, result, size, (pool->nworkers + 1) * POOL_CHUNKS);
+}
+
+//********************************************************************************************************
+// Private functions
+//********************************************************************************************************
+
+static inline void* node_alloc(struct lnklst_struct *lst, size_t size)
+{
+	return lst->allocator ? lst->allocator->alloc(size, lst->allocator->ctx) : lnklst_platform_alloc(size);
+}
+
+static inline void* node_realloc(struct lnklst_struct *lst, void *ptr, size_t size)
+{
+	return lst->allocator ? lst->allocator->realloc(ptr, size, lst->allocator->ctx) : lnklst_platform_realloc(ptr, size);
+}
+
+static inline void node_free(struct lnklst_struct *lst, void *ptr)
+{
+	if(lst->allocator)
+		lst->allocator->free(ptr, lst->allocator->ctx);
+	else
+		lnklst_platform_free(ptr);
+}
+
+//returns NULL if the allocator fails
+static struct header_struct* new_node(struct lnklst_struct *lst, size_t size)
+{
+	struct header_struct *retval = node_alloc(lst, sizeof(struct header_struct) + size);
+
+	if(retval)
+	{
+		retval->size = size;
+		retval->pad = 0;
+		retval->alignment = 0;
+		retval->slab = 0;
+	};
+
+	return retval;
+}
+
+//allocate a node whose allocation is aligned to alignment (a power of 2), placing the header as far into its block as needed
+static struct header_struct* new_node_aligned(struct lnklst_struct *lst, size_t size, size_t alignment)
+{
+	struct header_struct *retval;
+	uint8_t *block;
+	uintptr_t allocation;
+
+	if(alignment <= NODE_ALIGN)
+		retval = new_node(lst, size);
+	else
+	{
+		block = node_alloc(lst, offsetof(struct header_struct, allocation) + size + alignment - NODE_ALIGN);
+		allocation = ((uintptr_t)block + offsetof(struct header_struct, allocation) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		retval = (struct header_struct*)(allocation - offsetof(struct header_struct, allocation));
+		retval->size = size;
+		retval->pad = (uint8_t*)retval - block;
+		retval->alignment = alignment;
+		retval->slab = 0;
+	};
+
+	return retval;
+}
+
+//free a node's block, which starts pad bytes before its header. A slab is only freed along with the last node in it
+static void release_node(struct lnklst_struct *lst, struct header_struct *header)
+{
+	struct compact_slab_struct *slab;
+
+	if(header->slab)
+	{
+		//nodes in the same slab may have moved to other lists, freeing under other locks
+		slab = (struct compact_slab_struct*)((uint8_t*)header - header->pad);
+		if(!__atomic_sub_fetch(&slab->live, 1, __ATOMIC_ACQ_REL))
+			node_free(lst, slab);
+	}
+	else
+		node_free(lst, (uint8_t*)header - header->pad);
+}
+
+//bytes a copy of a node may take in a slab, including padding to align it
+static size_t slab_footprint(struct header_struct *header)
+{
+	size_t retval = offsetof(struct header_struct, allocation) + ((header->size + NODE_ALIGN - 1) & ~(size_t)(NODE_ALIGN - 1));
+
+	if(header->alignment > NODE_ALIGN)
+		retval += header->alignment - NODE_ALIGN;
+
+	return retval;
+}
+
+//carve a node for a copy of header from the slab at used bytes in, which is advanced past it
+static struct header_struct* slab_carve(struct compact_slab_struct *slab, size_t *used, struct header_struct *header)
+{
+	struct header_struct *retval;
+	uintptr_t allocation = (uintptr_t)slab + *used + offsetof(struct header_struct, allocation);
+
+	if(header->alignment > NODE_ALIGN)
+		allocation = (allocation + header->alignment - 1) & ~(uintptr_t)(header->alignment - 1);
+	retval = (struct header_struct*)(allocation - offsetof(struct header_struct, allocation));
+	retval->size = header->size;
+	retval->pad = (uint8_t*)retval - (uint8_t*)slab;
+	retval->alignment = header->alignment;
+	retval->slab = 1;
+	*used = allocation + ((header->size + NODE_ALIGN - 1) & ~(size_t)(NODE_ALIGN - 1)) - (uintptr_t)slab;
+	slab->live++;
+
+	return retval;
+}
+
+//step a run-ahead cursor up to hops headers towards the last (forward) or first, prefetching each, and return it
+//this compiles to nothing unless LNKLST_PREFETCH is defined
+static inline struct header_struct* prefetch_ahead(struct lnklst_struct *lst, struct header_struct *ahead, int hops, bool forward)
+{
+	#ifdef LNKLST_PREFETCH
+	while(hops-- && ahead && ahead != &lst->head)
+	{
+		ahead = forward ? ahead->after : ahead->before;
+		if(ahead)
+			lnklst_prefetch(ahead);
+	};
+	#else
+	(void)lst;
+	(void)hops;
+	(void)forward;
+	#endif
+	return ahead;
+}
+
+//put entry in the place of old, which is left unlinked
+static void replace_node(struct lnklst_struct *lst, struct header_struct *old, struct header_struct *entry)
+{
+	entry->before = old->before;
+	entry->after = old->after;
+	link_store(entry->after->before, entry);
+	if(entry->before)
+		link_store(entry->before->after, entry);
+	else
+		link_store(lst->head.after, entry);
+	if(lst->finger == old)
+		lst->finger = entry;
+}
+
+static void link_last(struct lnklst_struct *lst, struct header_struct *entry)
+{
+	entry->before = lst->head.before;
+	entry->after = &lst->head;
+	if(entry->before)
+		link_store(entry->before->after, entry);
+	else
+		link_store(lst->head.after, entry);	//list was empty, so this is also the first
+	link_store(lst->head.before, entry);
+	lst->count++;
+}
+
+//lock two different lists in address order, so that two threads locking the same pair in opposite roles can't deadlock
+static void lock_pair(struct lnklst_struct *a, struct lnklst_struct *b)
+{
+	if((uintptr_t)a > (uintptr_t)b)
+	{
+		lnklst_mutex_lock(&b->mutex);
+		lnklst_mutex_lock(&a->mutex);
+	}
+	else
+	{
+		lnklst_mutex_lock(&a->mutex);
+		lnklst_mutex_lock(&b->mutex);
+	};
+}
+
+//unlock a pair locked by lock_pair(), in the reverse order
+static void unlock_pair(struct lnklst_struct *a, struct lnklst_struct *b)
+{
+	if((uintptr_t)a > (uintptr_t)b)
+	{
+		lnklst_mutex_unlock(&a->mutex);
+		lnklst_mutex_unlock(&b->mutex);
+	}
+	else
+	{
+		lnklst_mutex_unlock(&b->mutex);
+		lnklst_mutex_unlock(&a->mutex);
+	};
+}
+
+//move all allocations in src to the back of dst, leaving src empty
+static void splice_last(struct lnklst_struct *dst, struct lnklst_struct *src)
+{
+	if(src->count)
+	{
+		//into an empty list, what was known to be sorted still is
+		if(!dst->count)
+		{
+			dst->sorted_by = src->sorted_by;
+			dst->sorted_count = src->sorted_count;
+		};
+		link_store(src->head.after->before, dst->head.before);
+		if(dst->head.before)
+			link_store(dst->head.before->after, src->head.after);
+		else
+			link_store(dst->head.after, src->head.after);
+		link_store(dst->head.before, src->head.before);
+		link_store(dst->head.before->after, &dst->head);
+		dst->count += src->count;
+
+		src->head.before = NULL;
+		src->head.after = NULL;
+		src->count = 0;
+		src->finger = NULL;
+		src->sorted_count = 0;
+	};
+}
+
+//called with the list locked, once chain (linked through chain_next()) has been unlinked from the list
+//returns the chain for the caller to free, or in LNKLST_EPOCH mode retires it, to be freed once no reader can reach it
+static struct header_struct* retire_chain(struct lnklst_struct *lst, struct header_struct *chain)
+{
+	#ifdef LNKLST_EPOCH
+	struct header_struct *x;
+	int slot = lst->epoch & 1;
+
+	while(chain)
+	{
+		x = chain->retired;
+		chain->retired = lst->limbo[slot];
+		lst->limbo[slot] = chain;
+		chain = x;
+	};
+	//twice, so that with no readers present what was just retired is freed
+	epoch_advance(lst);
+	epoch_advance(lst);
+	#else
+	(void)lst;
+	#endif
+	return chain;
+}
+
+//free a chain of headers, linked through chain_next()
+static void free_chain(struct lnklst_struct *lst, struct header_struct *chain)
+{
+	struct header_struct *x;
+
+	while(chain)
+	{
+		x = chain_next(chain);
+		release_node(lst, chain);
+		chain = x;
+	};
+}
+
+#ifdef LNKLST_EPOCH
+
+//called with the list locked. If there are no readers left from the previous epoch, free what was retired in it, and start the next
+static void epoch_advance(struct lnklst_struct *lst)
+{
+	unsigned previous = (lst->epoch - 1) & 1;
+
+	if(!__atomic_load_n(&lst->readers[previous], __ATOMIC_SEQ_CST))
+	{
+		free_chain(lst, lst->limbo[previous]);
+		lst->limbo[previous] = NULL;
+		__atomic_store_n(&lst->epoch, lst->epoch + 1, __ATOMIC_SEQ_CST);
+	};
+}
+
+#endif
+
+static void link_first(struct lnklst_struct *lst, struct header_struct *entry)
+{
+	entry->before = NULL;
+	if(lst->head.after)
+	{
+		entry->after = lst->head.after;
+		link_store(lst->head.after->before, entry);
+	}
+	else
+	{
+		//list was empty, so this is also the last
+		entry->after = &lst->head;
+		link_store(lst->head.before, entry);
+	};
+	link_store(lst->head.after, entry);
+	lst->count++;
+	lst->finger_index++;
+	lst->sorted_count = 0;
+}
+
+static void unlink_node(struct lnklst_struct *lst, struct header_struct *entry)
+{
+	//the finger survives removal of the first or last, otherwise it's index is unknown
+	if(lst->finger)
+	{
+		if(entry == lst->head.after && entry != lst->finger)
+			lst->finger_index--;
+		else if(entry != lst->head.before || entry == lst->finger)
+			lst->finger = NULL;
+	};
+
+	//change the *before link in the header after this one, from this header to this headers *before link
+	link_store(entry->after->before, entry->before);
+	//if there was a header before this one
+	if(entry->before)
+		//change the *after link in the header before this one, from this header to this headers *after link
+		link_store(entry->before->after, entry->after);
+	else
+		//this was the first, the one after it (if any) is now the first
+		link_store(lst->head.after, (entry->after != &lst->head) ? entry->after : NULL);
+	lst->count--;
+	//whether or not it was in the sorted part, one fewer from the first is still sorted
+	if(lst->sorted_count)
+		lst->sorted_count--;
+}
+
+//unlink target (which may be NULL for an empty list), copy it out and free it
+static bool pop_node(struct lnklst_struct *lst, struct header_struct *target, void *dst, size_t size)
+{
+	bool retval = false;
+
+	if(target)
+	{
+		unlink_node(lst, target);
+		if(dst)
+			memcpy(dst, &target->allocation, size);
+		chain_next(target) = NULL;
+		free_chain(lst, retire_chain(lst, target));
+		retval = true;
+	};
+
+	return retval;
+}
+
+#ifdef lnklst_cond_t
+
+//the time at which a wait of timeout_ms ends, or -1 to wait forever
+static int64_t queue_deadline(int timeout_ms)
+{
+	int64_t retval = -1;
+
+	if(timeout_ms >= 0)
+	{
+		#ifdef lnklst_clock_ms
+		retval = lnklst_clock_ms() + timeout_ms;
+		#elif defined(CLOCK_MONOTONIC)
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		retval = (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000 + timeout_ms;
+		#else
+		//with no clock, each wakeup restarts the timeout
+		retval = timeout_ms;
+		#endif
+	};
+
+	return retval;
+}
+
+//wait on cond with the list mutex held, until woken or the deadline from queue_deadline() passes, returns false if timed out
+static bool queue_wait(struct lnklst_struct *lst, lnklst_cond_t *cond, int *waiting, int64_t deadline)
+{
+	bool retval = true;
+	int64_t remaining = 0;
+
+	if(deadline >= 0)
+		remaining = deadline - queue_deadline(0);	//less now
+	if(deadline >= 0 && remaining <= 0)
+		retval = false;
+	else
+	{
+		(*waiting)++;
+		if(deadline < 0)
+			lnklst_cond_wait(cond, &lst->mutex);
+		else if(lnklst_cond_timedwait(cond, &lst->mutex, (int)remaining))
+			retval = false;
+		(*waiting)--;
+	};
+
+	return retval;
+}
+
+//wake the threads waiting on cond, once for a batch of count changes, and only if there are any waiting
+static void queue_wake(lnklst_cond_t *cond, int waiting, int count)
+{
+	if(waiting && count)
+	{
+		if(count > 1)
+			lnklst_cond_broadcast(cond);
+		else
+			lnklst_cond_signal(cond);
+	};
+}
+
+//wake every thread waiting on cond, where what changed may let all of them continue
+static void queue_wake_all(lnklst_cond_t *cond, int waiting)
+{
+	if(waiting)
+		lnklst_cond_broadcast(cond);
+}
+
+#endif
+
+//return the header at index (which must be in range), walking from whichever of the first, last or finger is nearest
+static struct header_struct* seek_index(struct lnklst_struct *lst, int index)
+{
+	struct header_struct *x;
+	struct header_struct *ahead;
+	int from_finger;
+	int steps;
+
+	//from the first
+	x = lst->head.after;
+	steps = index;
+	//from the last
+	if(lst->count - 1 - index < steps)
+	{
+		x = lst->head.before;
+		steps = index - (lst->count - 1);
+	};
+	//from the finger
+	if(lst->finger)
+	{
+		from_finger = index - lst->finger_index;
+		if((from_finger < 0 ? -from_finger : from_finger) < (steps < 0 ? -steps : steps))
+		{
+			x = lst->finger;
+			steps = from_finger;
+		};
+	};
+
+	//the run-ahead cursor stops at the end of the list, which is no further than the index being sought
+	ahead = prefetch_ahead(lst, x, LNKLST_PREFETCH_DISTANCE, steps > 0);
+	while(steps > 0)
+	{
+		ahead = prefetch_ahead(lst, ahead, 1, true);
+		x = x->after;
+		steps--;
+	};
+	while(steps < 0)
+	{
+		ahead = prefetch_ahead(lst, ahead, 1, false);
+		x = x->before;
+		steps++;
+	};
+
+	lst->finger = x;
+	lst->finger_index = index;
+	return x;
+}
+
+//return the address of the link which points to the entry matching key (the link points to NULL if there is no match)
+static struct lru_entry_struct** lru_find(struct lnklst_lru_struct *lru, void *key, uint32_t hash)
+{
+	struct lru_entry_struct **link = &lru->buckets[hash & (lru->bucket_count - 1)];
+
+	while(*link && ((*link)->hash != hash || lru->keycmp(lru->keyfunc((*link)->data), key)))
+		link = &(*link)->next;
+
+	return link;
+}
+
+static void lru_remove(struct lnklst_lru_struct *lru, struct lru_entry_struct **link)
+{
+	struct lru_entry_struct *entry = *link;
+	struct header_struct *header = container_of(entry, struct header_struct, allocation);
+
+	*link = entry->next;
+	unlink_node(lru->lst, header);
+	lru->bytes -= entry->size;
+	if(lru->evictfunc)
+		lru->evictfunc(entry->data);
+	release_node(lru->lst, header);
+}
+
+//double the number of buckets, and re-index every entry
+static void lru_grow(struct lnklst_lru_struct *lru)
+{
+	struct header_struct *x;
+	struct lru_entry_struct *entry;
+	uint32_t bucket_count = lru->bucket_count * 2;
+
+	lnklst_platform_free(lru->buckets);
+	lru->buckets = lnklst_platform_alloc(bucket_count * sizeof(struct lru_entry_struct*));
+	memset(lru->buckets, 0, bucket_count * sizeof(struct lru_entry_struct*));
+	lru->bucket_count = bucket_count;
+
+	x = lru->lst->head.after;
+	while(x && x != &lru->lst->head)
+	{
+		entry = (struct lru_entry_struct*)&x->allocation;
+		entry->next = lru->buckets[entry->hash & (bucket_count - 1)];
+		lru->buckets[entry->hash & (bucket_count - 1)] = entry;
+		x = x->after;
+	};
+}
+
+//re-link the list into order with a stable merge sort. If it is known to be sorted by swapfunc up to a point, only the allocations after that are sorted, then merged with the rest
+static void sort_list(struct lnklst_struct *lst, int(*swapfunc)(void*, void*))
+{
+	struct header_struct *tail;
+	struct header_struct *chain;
+	int unsorted = lst->count;
+
+	if(lst->sorted_by == swapfunc)
+		unsorted -= lst->sorted_count;
+	if(unsorted)
+	{
+		//walk back to the first allocation not known to be sorted
+		tail = lst->head.before;
+		while(--unsorted)
+			tail = tail->before;
+		chain = tail->before;
+		if(chain)
+		{
+			chain->after = NULL;
+			chain = detach_chain(lst);
+			chain = merge_chains(chain, sort_chain(tail, swapfunc), swapfunc);
+		}
+		else
+			chain = sort_chain(detach_chain(lst), swapfunc);
+		relink_chain(lst, chain);
+	};
+}
+
+//sort a chain linked through *after and ending in NULL, merging runs of 1, 2, 4... allocations as they are reached
+//levels[i] holds a sorted run of 2^i allocations or NULL, and runs at higher levels are from earlier in the chain
+static struct header_struct* sort_chain(struct header_struct *chain, int(*swapfunc)(void*, void*))
+{
+	struct header_struct *levels[SORT_LEVELS] = {NULL};
+	struct header_struct *run;
+	int i;
+
+	while(chain)
+	{
+		lnklst_prefetch(chain->after);
+		run = chain;
+		chain = chain->after;
+		run->after = NULL;
+		for(i = 0; levels[i]; i++)
+		{
+			run = merge_chains(levels[i], run, swapfunc);
+			levels[i] = NULL;
+		};
+		levels[i] = run;
+	};
+
+	run = NULL;
+	for(i = 0; i < SORT_LEVELS; i++)
+	{
+		if(levels[i])
+			run = run ? merge_chains(levels[i], run, swapfunc) : levels[i];
+	};
+
+	return run;
+}
+
+//return true if element is one of the used elements in block
+static bool unrolled_contains(struct lnklst_unrolled_struct *lst, struct header_struct *block, void *element)
+{
+	struct unrolled_block_struct *b = block_of(block);
+	return (uint8_t*)element >= b->elements && (uint8_t*)element < &b->elements[b->used * lst->elem_size];
+}
+
+//return the block containing element (or NULL), trying the finger and it's neighbours before searching from the first
+static struct header_struct* unrolled_find(struct lnklst_unrolled_struct *lst, void *element)
+{
+	struct header_struct *retval = NULL;
+	struct header_struct *x;
+
+	if(lst->finger)
+	{
+		if(unrolled_contains(lst, lst->finger, element))
+			retval = lst->finger;
+		else if(lst->finger->after != &lst->blocks->head && unrolled_contains(lst, lst->finger->after, element))
+		{
+			lst->finger_index += block_of(lst->finger)->used;
+			retval = lst->finger = lst->finger->after;
+		}
+		else if(lst->finger->before && unrolled_contains(lst, lst->finger->before, element))
+		{
+			lst->finger_index -= block_of(lst->finger->before)->used;
+			retval = lst->finger = lst->finger->before;
+		};
+	};
+
+	if(!retval)
+	{
+		lst->finger_index = 0;
+		x = lst->blocks->head.after;
+		while(x && x != &lst->blocks->head && !retval)
+		{
+			if(unrolled_contains(lst, x, element))
+				retval = lst->finger = x;
+			else
+			{
+				lst->finger_index += block_of(x)->used;
+				x = x->after;
+			};
+		};
+		if(!retval)
+			lst->finger = NULL;
+	};
+
+	return retval;
+}
+
+//return the block containing index (which must be in range), walking from whichever of the first, last or finger is nearest
+//the finger is left on the block returned
+static struct header_struct* unrolled_seek(struct lnklst_unrolled_struct *lst, int index)
+{
+	struct header_struct *x;
+	int base;
+
+	//from the first, or the last
+	if(index < lst->count / 2)
+	{
+		x = lst->blocks->head.after;
+		base = 0;
+	}
+	else
+	{
+		x = lst->blocks->head.before;
+		base = lst->count - block_of(x)->used;
+	};
+	//or from the finger
+	if(lst->finger && (index - lst->finger_index < 0 ? lst->finger_index - index : index - lst->finger_index) < (index - base < 0 ? base - index : index - base))
+	{
+		x = lst->finger;
+		base = lst->finger_index;
+	};
+
+	while(index < base)
+	{
+		x = x->before;
+		base -= block_of(x)->used;
+	};
+	while(index >= base + block_of(x)->used)
+	{
+		base += block_of(x)->used;
+		x = x->after;
+	};
+
+	lst->finger = x;
+	lst->finger_index = base;
+	return x;
+}
+
+
+//FNV style hash taken a 64 bit word at a time, with any partial word at the end zero padded
+static uint64_t image_hash(uint64_t hash, const void *data, size_t len)
+{
+	const uint8_t *src = data;
+	uint64_t word;
+
+	while(len)
+	{
+		word = 0;
+		memcpy(&word, src, len < sizeof(word) ? len : sizeof(word));
+		hash = (hash ^ word) * 0x100000001B3ull;
+		src += len < sizeof(word) ? len : sizeof(word);
+		len -= len < sizeof(word) ? len : sizeof(word);
+	};
+
+	return hash;
+}
+
+static bool image_valid(const struct lnklst_map_struct *image)
+{
+	return image->magic == IMAGE_MAGIC && image->version == IMAGE_VERSION && image->count <= INT32_MAX && !(image->flags & ~IMAGE_CHECKSUM);
+}
+
+
+//first fit from the free blocks of the region, splitting off the remainder if it is big enough to be useful
+static struct shm_block_struct* shm_alloc(struct lnklst_shm_struct *shm, size_t size)
+{
+	struct shm_block_struct *retval = NULL;
+	struct shm_block_struct *block;
+	struct shm_block_struct *rest;
+	uint64_t *link = &shm->free;
+	size_t need = sizeof(struct shm_block_struct) + shm_round(size);
+
+	while(*link && !retval)
+	{
+		block = shm_block(shm, *link);
+		if(block->size >= need)
+		{
+			if(block->size - need >= sizeof(struct shm_block_struct) + SHM_ALIGN)
+			{
+				rest = shm_block(shm, *link + need);
+				rest->size = block->size - need;
+				rest->after = block->after;
+				block->size = need;
+				*link = shm_offset(shm, rest);
+			}
+			else
+				*link = block->after;
+			block->used = size;
+			retval = block;
+		}
+		else
+			link = &block->after;
+	};
+
+	return retval;
+}
+
+//return a block to the free blocks, merging it with its neighbours if they are free
+static void shm_release(struct lnklst_shm_struct *shm, struct shm_block_struct *block)
+{
+	struct shm_block_struct *prev = NULL;
+	struct shm_block_struct *next;
+	uint64_t offset = shm_offset(shm, block);
+	uint64_t next_offset = shm->free;
+
+	while(next_offset && next_offset < offset)
+	{
+		prev = shm_block(shm, next_offset);
+		next_offset = prev->after;
+	};
+
+	block->after = next_offset;
+	if(prev)
+		prev->after = offset;
+	else
+		shm->free = offset;
+
+	if(next_offset && offset + block->size == next_offset)
+	{
+		next = shm_block(shm, next_offset);
+		block->size += next->size;
+		block->after = next->after;
+	};
+	if(prev && shm_offset(shm, prev) + prev->size == offset)
+	{
+		prev->size += block->size;
+		prev->after = block->after;
+	};
+}
+
+static void shm_link_last(struct lnklst_shm_struct *shm, struct shm_block_struct *block)
+{
+	uint64_t offset = shm_offset(shm, block);
+
+	block->before = shm->last;
+	block->after = 0;
+	if(shm->last)
+		shm_block(shm, shm->last)->after = offset;
+	else
+		shm->first = offset;
+	shm->last = offset;
+	shm->count++;
+}
+
+static void shm_remove(struct lnklst_shm_struct *shm, struct shm_block_struct *block)
+{
+	if(block->before)
+		shm_block(shm, block->before)->after = block->after;
+	else
+		shm->first = block->after;
+	if(block->after)
+		shm_block(shm, block->after)->before = block->before;
+	else
+		shm->last = block->before;
+	shm->count--;
+}
+
+
+//bump allocate from the current chunk of the calling thread's node, starting a new chunk when it is full
+static void* arena_alloc(size_t size, void *ctx)
+{
+	struct lnklst_arena_struct *arena = ctx;
+	struct arena_chunk_struct *chunk;
+	struct arena_prefix_struct *prefix = NULL;
+	size_t need = sizeof(struct arena_prefix_struct) + ((size + NODE_ALIGN - 1) & ~(size_t)(NODE_ALIGN - 1));
+	int node;
+
+	//unless the size is so large that rounding it, or adding a chunk header, would wrap
+	if(size <= SIZE_MAX - ARENA_MIN_CHUNK)
+	{
+		node = arena_node(arena);
+		lnklst_mutex_lock(&arena->mutex);
+		chunk = arena->current[node];
+		if(!chunk || chunk->size - chunk->used < need)
+		{
+			//one too large for a chunk gets its own, without replacing the current one
+			if(need > arena->chunk_size - sizeof(struct arena_chunk_struct))
+				chunk = arena_new_chunk(arena, sizeof(struct arena_chunk_struct) + need, node);
+			else
+			{
+				chunk = arena_new_chunk(arena, arena->chunk_size, node);
+				if(chunk)
+					arena->current[node] = chunk;
+			};
+		};
+		if(chunk)
+		{
+			prefix = (struct arena_prefix_struct*)((uint8_t*)chunk + chunk->used);
+			prefix->chunk = chunk;
+			prefix->size = size;
+			chunk->used += need;
+			chunk->live++;
+			prefix++;
+		};
+		lnklst_mutex_unlock(&arena->mutex);
+	};
+
+	return prefix;
+}
+
+static void* arena_realloc(void *ptr, size_t size, void *ctx)
+{
+	struct arena_prefix_struct *prefix = (struct arena_prefix_struct*)ptr - 1;
+	void *retval = ptr;
+
+	//shrink in place, or move
+	if(size > prefix->size)
+	{
+		retval = arena_alloc(size, ctx);
+		memcpy(retval, ptr, prefix->size);
+		arena_free(ptr, ctx);
+	};
+
+	return retval;
+}
+
+static void arena_free(void *ptr, void *ctx)
+{
+	struct lnklst_arena_struct *arena = ctx;
+	struct arena_chunk_struct *chunk = ((struct arena_prefix_struct*)ptr - 1)->chunk;
+
+	lnklst_mutex_lock(&arena->mutex);
+	if(!--chunk->live)
+	{
+		//a chunk being allocated from is reused, any other is returned
+		if(chunk == arena->current[chunk->node])
+			chunk->used = sizeof(struct arena_chunk_struct);
+		else
+			arena_release_chunk(arena, chunk);
+	};
+	lnklst_mutex_unlock(&arena->mutex);
+}
+
+//add a chunk on the node to the arena's chunks. Returns NULL if it could not be allocated
+static struct arena_chunk_struct* arena_new_chunk(struct lnklst_arena_struct *arena, size_t size, int node)
+{
+	struct arena_chunk_struct *retval = chunk_alloc(size, node);
+
+	if(retval)
+	{
+		retval->size = size;
+		retval->used = sizeof(struct arena_chunk_struct);
+		retval->live = 0;
+		retval->node = node;
+		retval->before = NULL;
+		retval->after = arena->chunks;
+		if(arena->chunks)
+			arena->chunks->before = retval;
+		arena->chunks = retval;
+	};
+
+	return retval;
+}
+
+static void arena_release_chunk(struct lnklst_arena_struct *arena, struct arena_chunk_struct *chunk)
+{
+	if(chunk->before)
+		chunk->before->after = chunk->after;
+	else
+		arena->chunks = chunk->after;
+	if(chunk->after)
+		chunk->after->before = chunk->before;
+	chunk_free(chunk, chunk->size);
+}
+
+//the number of NUMA nodes an arena keeps a current chunk for
+static int arena_nodes(void)
+{
+	int retval = 1;
+
+	#if !defined(lnklst_platform_chunk_alloc) && defined(LNKLST_NUMA)
+	if(numa_available() >= 0)
+		retval = numa_max_node() + 1;
+	#endif
+
+	return retval;
+}
+
+//the NUMA node the calling thread is running on, or 0
+static int arena_node(struct lnklst_arena_struct *arena)
+{
+	int retval = 0;
+
+	#if !defined(lnklst_platform_chunk_alloc) && defined(LNKLST_NUMA)
+	if(arena->nodes > 1)
+	{
+		retval = numa_node_of_cpu(sched_getcpu());
+		if(retval < 0 || retval >= arena->nodes)
+			retval = 0;
+	};
+	#else
+	(void)arena;
+	#endif
+
+	return retval;
+}
+
+//a chunk from the platform hooks, or mapped with huge pages and/or bound to the NUMA node, or NULL
+static void* chunk_alloc(size_t size, int node)
+{
+	void *retval;
+
+	#if defined(lnklst_platform_chunk_alloc)
+	(void)node;
+	retval = lnklst_platform_chunk_alloc(size);
+	#elif defined(LNKLST_HUGEPAGES) || defined(LNKLST_NUMA)
+	retval = MAP_FAILED;
+	#if defined(LNKLST_HUGEPAGES) && defined(MAP_HUGETLB)
+	if(!(size & (HUGE_PAGE_SIZE - 1)))
+		retval = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	#endif
+	if(retval == MAP_FAILED)
+	{
+		retval = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		#if defined(LNKLST_HUGEPAGES) && defined(MADV_HUGEPAGE)
+		if(retval != MAP_FAILED)
+			madvise(retval, size, MADV_HUGEPAGE);
+		#endif
+	};
+	#ifdef LNKLST_NUMA
+	//bind the mapping to the node before any of it is touched, whichever pages it uses
+	if(retval != MAP_FAILED && numa_available() >= 0)
+		numa_tonode_memory(retval, size, node);
+	#else
+	(void)node;
+	#endif
+	if(retval == MAP_FAILED)
+		retval = NULL;
+	#else
+	(void)node;
+	retval = lnklst_platform_alloc(size);
+	#endif
+
+	return retval;
+}
+
+static void chunk_free(void *ptr, size_t size)
+{
+	#if defined(lnklst_platform_chunk_free)
+	lnklst_platform_chunk_free(ptr, size);
+	#elif defined(LNKLST_HUGEPAGES) || defined(LNKLST_NUMA)
+	munmap(ptr, size);
+	#else
+	(void)size;
+	lnklst_platform_free(ptr);
+	#endif
+}
+
+
+//split the list into up to count segments of near equal length in one pass, returns the number of segments
+static int split_segments(struct lnklst_struct *lst, struct parallel_segment_struct *segments, int count)
+{
+	struct header_struct *x = lst->head.after;
+	int length = (lst->count + count - 1) / count;
+	int retval = 0;
+	int i;
+
+	while(x && x != &lst->head && retval < count)
+	{
+		segments[retval].first = x;
+		for(i = 0; i < length && x != &lst->head; i++)
+		{
+			lnklst_prefetch(x->after);
+			x = x->after;
+		};
+		segments[retval++].end = x;
+	};
+
+	return retval;
+}
+
+//run all but the last segment on threads of their own if there are any, and the last on this thread
+static void run_segments(struct parallel_segment_struct *segments, int count)
+{
+	int i;
+
+	#ifdef lnklst_thread_t
+	for(i = 0; i < count - 1; i++)
+	{
+		segments[i].threaded = !lnklst_thread_create(&segments[i].thread, run_segment, &segments[i]);
+		if(!segments[i].threaded)
+			run_segment(&segments[i]);
+	};
+	if(count)
+		run_segment(&segments[count - 1]);
+	for(i = 0; i < count - 1; i++)
+	{
+		if(segments[i].threaded)
+			lnklst_thread_join(segments[i].thread);
+	};
+	#else
+	for(i = 0; i < count; i++)
+		run_segment(&segments[i]);
+	#endif
+}
+
+static void* run_segment(void *arg)
+{
+	struct parallel_segment_struct *segment = arg;
+	struct header_struct *x = segment->first;
+
+	while(x != segment->end)
+	{
+		lnklst_prefetch(x->after);
+		if(segment->fn)
+			segment->fn(&x->allocation, segment->ctx);
+		else
+			segment->map(segment->acc, &x->allocation);
+		x = x->after;
+	};
+
+	return NULL;
+}
+
+
+static void parallel_foreach(struct lnklst_struct *lst, struct lnklst_pool_struct *pool, void(*fn)(void*, void*), void *ctx, int nsegments)
+{
+	struct parallel_segment_struct *segments;
+	int i;
+
+	segments = lnklst_platform_alloc(nsegments * sizeof(struct parallel_segment_struct));
+	for(i = 0; i < nsegments; i++)
+	{
+		segments[i].fn = fn;
+		segments[i].ctx = ctx;
+	};
+	parallel_run(lst, pool, segments, nsegments);
+	lnklst_platform_free(segments);
+}
+
+static void parallel_reduce(struct lnklst_struct *lst, struct lnklst_pool_struct *pool, void(*map)(void*, void*), void(*combine)(void*, void*), const void *identity, void *result, size_t size, int nsegments)
+{
+	struct parallel_segment_struct *segments;
+	uint8_t *accs;
+	size_t stride = (size + NODE_ALIGN - 1) & ~(size_t)(NODE_ALIGN - 1);
+	int count;
+	int i;
+
+	//each segment's accumulator, followed by the segments
+	accs = lnklst_platform_alloc(nsegments * (stride + sizeof(struct parallel_segment_struct)));
+	segments = (struct parallel_segment_struct*)(accs + nsegments * stride);
+	for(i = 0; i < nsegments; i++)
+	{
+		segments[i].fn = NULL;
+		segments[i].map = map;
+		segments[i].acc = accs + i * stride;
+		memcpy(segments[i].acc, identity, size);
+	};
+	count = parallel_run(lst, pool, segments, nsegments);
+
+	memcpy(result, identity, size);
+	for(i = 0; i < count; i++)
+		combine(result, segments[i].acc);
+	lnklst_platform_free(accs);
+}
+
+//split the list into segments and run them on the pool, or on threads of their own, under the list's lock. Returns the number of segments
+static int parallel_run(struct lnklst_struct *lst, struct lnklst_pool_struct *pool, struct parallel_segment_struct *segments, int nsegments)
+{
+	int retval;
+
+	lnklst_mutex_lock(&lst->mutex);
+	retval = split_segments(lst, segments, nsegments);
+	#ifdef POOL_THREADS
+	if(pool)
+		pool_run(pool, segments, retval);
+	else
+	#else
+	(void)pool;
+	#endif
+		run_segments(segments, retval);
+	lnklst_mutex_unlock(&lst->mutex);
+
+	return retval;
+}
+
+#ifdef POOL_THREADS
+
+//deal the segments out to every queue in runs, wake the workers, work alongside them, and wait until every segment is done
+static void pool_run(struct lnklst_pool_struct *pool, struct parallel_segment_struct *segments, int count)
+{
+	int queues = pool->nworkers + 1;
+	int i;
+
+	lnklst_mutex_lock(&pool->run);
+	lnklst_mutex_lock(&pool->mutex);
+	pool->segments = segments;
+	pool->remaining = count;
+	for(i = 0; i < queues; i++)
+	{
+		lnklst_mutex_lock(&pool->workers[i].mutex);
+		pool->workers[i].top = count * i / queues;
+		pool->workers[i].bottom = count * (i + 1) / queues;
+		lnklst_mutex_unlock(&pool->workers[i].mutex);
+	};
+	pool->generation++;
+	lnklst_cond_broadcast(&pool->work);
+	lnklst_mutex_unlock(&pool->mutex);
+
+	pool_work(pool, pool->nworkers);
+
+	//no worker may still be looking at the segments once we return
+	lnklst_mutex_lock(&pool->mutex);
+	while(pool->remaining || pool->busy)
+		lnklst_cond_wait(&pool->done, &pool->mutex);
+	pool->segments = NULL;
+	lnklst_mutex_unlock(&pool->mutex);
+	lnklst_mutex_unlock(&pool->run);
+}
+
+static void* pool_worker(void *arg)
+{
+	struct pool_worker_struct *worker = arg;
+	struct lnklst_pool_struct *pool = worker->pool;
+	unsigned seen = 0;
+
+	lnklst_mutex_lock(&pool->mutex);
+	while(!pool->stop)
+	{
+		if(pool->generation == seen)
+			lnklst_cond_wait(&pool->work, &pool->mutex);
+		else
+		{
+			seen = pool->generation;
+			pool->busy++;
+			lnklst_mutex_unlock(&pool->mutex);
+			pool_work(pool, worker->index);
+			lnklst_mutex_lock(&pool->mutex);
+			if(!--pool->busy)
+				lnklst_cond_signal(&pool->done);
+		};
+	};
+	lnklst_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+//run segments from our own queue, then stolen from others, until there are none left
+static void pool_work(struct lnklst_pool_struct *pool, int self)
+{
+	int segment;
+
+	while((segment = pool_take(pool, self)) >= 0)
+	{
+		run_segment(&pool->segments[segment]);
+		lnklst_mutex_lock(&pool->mutex);
+		if(!--pool->remaining)
+			lnklst_cond_signal(&pool->done);
+		lnklst_mutex_unlock(&pool->mutex);
+	};
+}
+
+static int pool_take(struct lnklst_pool_struct *pool, int self)
+{
+	struct pool_worker_struct *victim;
+	int queues = pool->nworkers + 1;
+	int retval = -1;
+	int i;
+
+	for(i = 0; i < queues && retval < 0; i++)
+	{
+		victim = &pool->workers[(self + i) % queues];
+		lnklst_mutex_lock(&victim->mutex);
+		if(victim->top < victim->bottom)
+			retval = i ? --victim->bottom : victim->top++;
+		lnklst_mutex_unlock(&victim->mutex);
+	};
+
+	return retval;
+}
+
+#endif
+
+
+//compare length bytes, 16 at a time with SSE2 where available, then 8 at a time
+static inline bool bytes_equal(const uint8_t *a, const uint8_t *b, size_t length)
+{
+	uint64_t wa;
+	uint64_t wb;
+	bool retval = true;
+
+	#ifdef __SSE2__
+	while(retval && length >= 16)
+	{
+		retval = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)a), _mm_loadu_si128((const __m128i*)b))) == 0xFFFF;
+		a += 16;
+		b += 16;
+		length -= 16;
+	};
+	#endif
+	while(retval && length >= 8)
+	{
+		memcpy(&wa, a, 8);
+		memcpy(&wb, b, 8);
+		retval = wa == wb;
+		a += 8;
+		b += 8;
+		length -= 8;
+	};
+	while(retval && length)
+	{
+		retval = *a++ == *b++;
+		length--;
+	};
+
+	return retval;
+}
+
+
+//called with the list locked, empty the list, returning its allocations as a chain linked through *after, ending in NULL
+//the count is left for the caller to adjust
+static struct header_struct* detach_chain(struct lnklst_struct *lst)
+{
+	struct header_struct *retval = lst->head.after;
+
+	if(retval)
+		lst->head.before->after = NULL;
+	lst->head.before = NULL;
+	lst->head.after = NULL;
+	lst->finger = NULL;
+	lst->sorted_count = 0;
+
+	return retval;
+}
+
+//called with the list locked, and empty, link a chain (linked through *after, ending in NULL) into it in order
+static void relink_chain(struct lnklst_struct *lst, struct header_struct *chain)
+{
+	struct header_struct *prev = NULL;
+
+	link_store(lst->head.after, chain);
+	while(chain)
+	{
+		link_store(chain->before, prev);
+		prev = chain;
+		chain = chain->after;
+	};
+	if(prev)
+		link_store(prev->after, &lst->head);
+	link_store(lst->head.before, prev);
+	lst->finger = NULL;
+}
+
+//called with the list locked, re-link it into the order of an array of all count (at least 1) of its allocations
+static void relink_array(struct lnklst_struct *lst, void **allocations, int count)
+{
+	struct header_struct *x;
+	struct header_struct *prev = NULL;
+	int i;
+
+	lst->finger = NULL;
+	for(i = 0; i < count; i++)
+	{
+		x = container_of(allocations[i], struct header_struct, allocation);
+		link_store(x->before, prev);
+		if(prev)
+			link_store(prev->after, x);
+		else
+			link_store(lst->head.after, x);
+		prev = x;
+	};
+	link_store(prev->after, &lst->head);
+	link_store(lst->head.before, prev);
+	lst->sorted_count = 0;
+}
+
+//stable bottom up merge sort of count pointers by what they point to, using scratch of the same length
+static void sort_pointers(void **array, void **scratch, int count, int(*swapfunc)(void*, void*))
+{
+	void **from = array;
+	void **to = scratch;
+	void **swap;
+	int width, lo, mid, hi, i, j, k;
+
+	for(width = 1; width < count; width = width > count / 2 ? count : width * 2)
+	{
+		for(lo = 0; lo < count; lo = hi)
+		{
+			mid = width < count - lo ? lo + width : count;
+			hi = width < count - mid ? mid + width : count;
+			//the right run only goes first where it sorts strictly before, so equal elements keep their order
+			for(i = lo, j = mid, k = lo; k < hi; k++)
+			{
+				if(j < hi && (i == mid || swapfunc(from[j], from[i]) < 0))
+					to[k] = from[j++];
+				else
+					to[k] = from[i++];
+			};
+		};
+		swap = from;
+		from = to;
+		to = swap;
+	};
+	if(from != array)
+		memcpy(array, from, count * sizeof(void*));
+}
+
+//merge two sorted chains, linked through *after and ending in NULL. Where allocations compare equal, those from a come first
+static struct header_struct* merge_chains(struct header_struct *a, struct header_struct *b, int(*swapfunc)(void*, void*))
+{
+	struct header_struct *retval = NULL;
+	struct header_struct **tail = &retval;
+
+	while(a && b)
+	{
+		lnklst_prefetch(a->after);
+		lnklst_prefetch(b->after);
+		if(swapfunc(&b->allocation, &a->allocation) < 0)
+		{
+			*tail = b;
+			b = b->after;
+		}
+		else
+		{
+			*tail = a;
+			a = a->after;
+		};
+		tail = &(*tail)->after;
+	};
+	*tail = a ? a : b;
+
+	return retval;
+}
+
+//whether a sorts before b, or is from an earlier order where they compare equal
+static inline bool heap_before(struct heap_entry_struct *a, struct heap_entry_struct *b, int(*swapfunc)(void*, void*))
+{
+	int diff = swapfunc(&a->node->allocation, &b->node->allocation);
+
+	return diff < 0 || (!diff && a->order < b->order);
+}
+
+//restore the heap below i, with the entry which sorts first (or last, if latest_first) at the top
+static void heap_down(struct heap_entry_struct *heap, int count, int i, int(*swapfunc)(void*, void*), bool latest_first)
+{
+	struct heap_entry_struct x;
+	int child;
+
+	while((child = 2 * i + 1) < count)
+	{
+		if(child + 1 < count && heap_before(&heap[child + 1], &heap[child], swapfunc) != latest_first)
+			child++;
+		if(heap_before(&heap[child], &heap[i], swapfunc) == latest_first)
+			break;
+		x = heap[i];
+		heap[i] = heap[child];
+		heap[child] = x;
+		i = child;
+	};
+}
+
+//whether srcs[i] is a list to merge from (and lock), rather than NULL, dst, a list already seen earlier in srcs, or one using another allocator
+static bool merge_source(struct lnklst_struct *dst, struct lnklst_struct **srcs, int i)
+{
+	bool retval = srcs[i] && srcs[i] != dst && srcs[i]->allocator == dst->allocator;
+	int j;
+
+	for(j = 0; retval && j < i; j++)
+		retval = srcs[j] != srcs[i];
+
+	return retval;
+}
+
+//called with the list locked, fill heap with the (up to) k allocations which a stable sort would place first, in sorted order
+//returns the number found. The heap holds the best so far with the worst of them on top, which each later allocation must beat
+static int select_first(struct lnklst_struct *lst, int k, int(*swapfunc)(void*, void*), struct heap_entry_struct *heap)
+{
+	struct header_struct *x;
+	struct header_struct *ahead;
+	struct heap_entry_struct entry;
+	int retval = 0;
+	int i;
+
+	x = lst->head.after;
+	ahead = prefetch_ahead(lst, x, LNKLST_PREFETCH_DISTANCE, true);
+	for(entry.order = 0; x && x != &lst->head; entry.order++)
+	{
+		ahead = prefetch_ahead(lst, ahead, 1, true);
+		entry.node = x;
+		if(retval < k)
+		{
+			heap[retval++] = entry;
+			if(retval == k)
+			{
+				for(i = k / 2 - 1; i >= 0; i--)
+					heap_down(heap, k, i, swapfunc, true);
+			};
+		}
+		else if(heap_before(&entry, &heap[0], swapfunc))
+		{
+			heap[0] = entry;
+			heap_down(heap, k, 0, swapfunc, true);
+		};
+		x = x->after;
+	};
+	if(retval < k)
+	{
+		for(i = retval / 2 - 1; i >= 0; i--)
+			heap_down(heap, retval, i, swapfunc, true);
+	};
+
+	//heap sort, moving the worst remaining to the end each time
+	for(i = retval - 1; i > 0; i--)
+	{
+		entry = heap[0];
+		heap[0] = heap[i];
+		heap[i] = entry;
+		heap_down(heap, i, 0, swapfunc, true);
+	};
+
+	return retval;
+}
+
+#endif
@@ -0,0 +1,222 @@
+/*
+	A C++ wrapper for lnklst.h, holding elements of type T.
+
+	The implementation is still compiled from C, in one C file as described in lnklst.h. Then in C++:
+
+		#include "lnklst.hpp"
+
+		lnklst::list<widget> widgets;
+		widgets.emplace_back(1, 2);
+		for(widget &w : widgets)
+			...
+		widgets.sort([](const widget &a, const widget &b) { return a.id < b.id; });
+
+	The list owns its elements, and is move only. Iterators walk the links directly rather than calling lnklst_after(),
+	so like std::list they do no locking, and a list shared between threads needs locking by the caller.
+	If the list or an element can't be allocated, std::bad_alloc is thrown.
+	sort() takes a comparator in the form of std::sort(), which is inlined rather than called through a function pointer.
+*/
+
+#ifndef _LNKLST_HPP_
+#define _LNKLST_HPP_
+
+	#include <algorithm>
+	#include <cstddef>
+	#include <functional>
+	#include <iterator>
+	#include <new>
+	#include <type_traits>
+	#include <utility>
+
+	#include "lnklst.h"
+
+namespace lnklst
+{
+
+	//the before and after links at the start of every node, and at the start of the list (the head)
+	struct links
+	{
+		links	*before;
+		links	*after;
+	};
+
+	template <typename T>
+	class list
+	{
+		static_assert(alignof(T) <= LNKLST_PLATFORM_ALIGN, "lnklst allocations are only aligned to LNKLST_PLATFORM_ALIGN");
+
+		template <typename U>
+		class basic_iterator
+		{
+			public:
+				typedef std::bidirectional_iterator_tag	iterator_category;
+				typedef T			value_type;
+				typedef std::ptrdiff_t	difference_type;
+				typedef U*			pointer;
+				typedef U&			reference;
+
+				basic_iterator() : node(nullptr) {}
+				explicit basic_iterator(links *node) : node(node) {}
+				//an iterator converts to a const_iterator
+				template <typename V, typename = typename std::enable_if<std::is_same<V, T>::value>::type>
+				basic_iterator(const basic_iterator<V> &other) : node(other.node) {}
+
+				reference operator*() const { return *element(node); }
+				pointer operator->() const { return element(node); }
+				basic_iterator& operator++() { node = node->after; return *this; }
+				basic_iterator operator++(int) { basic_iterator retval = *this; node = node->after; return retval; }
+				basic_iterator& operator--() { node = node->before; return *this; }
+				basic_iterator operator--(int) { basic_iterator retval = *this; node = node->before; return retval; }
+				bool operator==(const basic_iterator &other) const { return node == other.node; }
+				bool operator!=(const basic_iterator &other) const { return node != other.node; }
+
+			private:
+				links	*node;
+				friend class list;
+				template <typename> friend class basic_iterator;
+		};
+
+		public:
+			typedef T			value_type;
+			typedef T&			reference;
+			typedef const T&	const_reference;
+			typedef std::size_t	size_type;
+			typedef basic_iterator<T>		iterator;
+			typedef basic_iterator<const T>	const_iterator;
+
+			list() : lst(lnklst_create())
+			{
+				if(!lst)
+					throw std::bad_alloc();
+			}
+			~list() { destroy(); }
+
+			list(const list&) = delete;
+			list& operator=(const list&) = delete;
+			list(list &&other) noexcept : lst(other.lst) { other.lst = nullptr; }
+			list& operator=(list &&other) noexcept
+			{
+				if(this != &other)
+				{
+					destroy();
+					lst = other.lst;
+					other.lst = nullptr;
+				};
+				return *this;
+			}
+
+			//construct an element in place, in a new allocation at the back (last) of the list
+			template <typename... Args>
+			reference emplace_back(Args&&... args)
+			{
+				void *allocation = lnklst_push_back(lst, nullptr, sizeof(T));
+				if(!allocation)
+					throw std::bad_alloc();
+				try
+				{
+					return *new (allocation) T(std::forward<Args>(args)...);
+				}
+				catch(...)
+				{
+					lnklst_free(lst, allocation);
+					throw;
+				};
+			}
+
+			//construct an element in place, in a new allocation at the front (first) of the list
+			template <typename... Args>
+			reference emplace_front(Args&&... args)
+			{
+				void *allocation = lnklst_push_front(lst, nullptr, sizeof(T));
+				if(!allocation)
+					throw std::bad_alloc();
+				try
+				{
+					return *new (allocation) T(std::forward<Args>(args)...);
+				}
+				catch(...)
+				{
+					lnklst_free(lst, allocation);
+					throw;
+				};
+			}
+
+			void push_back(const T &value) { emplace_back(value); }
+			void push_back(T &&value) { emplace_back(std::move(value)); }
+			void push_front(const T &value) { emplace_front(value); }
+			void push_front(T &&value) { emplace_front(std::move(value)); }
+
+			void pop_front() { erase(begin()); }
+			void pop_back() { erase(--end()); }
+
+			//destroy the element at pos, and return an iterator to the one after it
+			iterator erase(const_iterator pos)
+			{
+				iterator retval(pos.node->after);
+				element(pos.node)->~T();
+				lnklst_free(lst, element(pos.node));
+				return retval;
+			}
+
+			void clear()
+			{
+				while(!empty())
+					pop_back();
+			}
+
+			reference front() { return *begin(); }
+			const_reference front() const { return *begin(); }
+			reference back() { return *--end(); }
+			const_reference back() const { return *--end(); }
+
+			iterator begin() { return iterator(first()); }
+			iterator end() { return iterator(head()); }
+			const_iterator begin() const { return const_iterator(first()); }
+			const_iterator end() const { return const_iterator(head()); }
+			const_iterator cbegin() const { return begin(); }
+			const_iterator cend() const { return end(); }
+
+			size_type size() const { return lnklst_count(lst); }
+			bool empty() const { return !head()->after; }
+
+			//sort the elements by re-linking them, comp(a, b) returns true if a belongs before b, as for std::sort()
+			//the list stays locked from gathering the elements to re-linking them, so comp must not throw, or use the list
+			template <typename Compare = std::less<T>>
+			void sort(Compare comp = Compare())
+			{
+				lnklst_sort_gathered(lst, &sort_gathered<Compare>, &comp);
+			}
+
+			//the underlying list, for use with the C API
+			struct lnklst_struct* native_handle() { return lst; }
+
+		private:
+			struct lnklst_struct	*lst;
+
+			//the list starts with its head, whose before is the last node, and after is the first (or NULL if empty)
+			links* head() const { return reinterpret_cast<links*>(lst); }
+			links* first() const { return head()->after ? head()->after : head(); }
+
+			static T* element(links *node) { return reinterpret_cast<T*>(reinterpret_cast<char*>(node) + lnklst_header_size); }
+
+			template <typename Compare>
+			static void sort_gathered(void **allocations, int count, void *ctx)
+			{
+				Compare &comp = *static_cast<Compare*>(ctx);
+				std::stable_sort(allocations, allocations + count, [&comp](void *a, void *b) { return comp(*static_cast<T*>(a), *static_cast<T*>(b)); });
+			}
+
+			void destroy()
+			{
+				if(lst)
+				{
+					for(links *node = head()->after; node && node != head(); node = node->after)
+						element(node)->~T();
+					lnklst_destroy(&lst);
+				};
+			}
+	};
+
+}
+
+#endif
@@ -1,35 +1,98 @@
-	#include <stddef.h>
-	#include <stdlib.h>
-
-	int test_lock_count = 0;
-	int test_unlock_count = 0;
-	int test_init_count = 0;
-	int test_destroy_count = 0;
-	int test_allocation_count = 0;
-
-	static void* platform_allocate(size_t sz)
-	{
-		test_allocation_count++;
-		return malloc(sz);
-	};
-
-	static void platform_free(void *ptr)
-	{
-		test_allocation_count--;
-		free(ptr);
-	};
-
-//	Mandatory allocator
-	#include <stdlib.h>
-	#define lnklst_platform_alloc(sz)	platform_allocate(sz)
-	#define lnklst_platform_free(ptr)	platform_free(ptr)
-
-//	Optional thread safety
-	#define lnklst_mutex_lock(arg)		do{test_lock_count++;}while(0)
-	#define lnklst_mutex_unlock(arg)	do{test_unlock_count++;}while(0)
-	#define lnklst_mutex_init(arg)		do{test_init_count++;}while(0)
-	#define lnklst_mutex_destroy(arg)	do{test_destroy_count++;}while(0)
-	#define lnklst_mutex_t				int
-
-	#define LNKLST_IMPLEMENTATION
-	#include "lnklst.h"
+	#include <stddef.h>
+	#include <stdint.h>
+	#include <stdlib.h>
+
+	int test_lock_count = 0;
+	int test_unlock_count = 0;
+	int test_init_count = 0;
+	int test_destroy_count = 0;
+	int test_allocation_count = 0;
+	int test_wait_count = 0;
+	int test_signal_count = 0;
+	int test_broadcast_count = 0;
+	const void *test_last_locked = NULL;
+	int test_failing_allocations = 0;	//the next allocations which return NULL, as if out of memory
+
+	static void* platform_allocate(size_t sz)
+	{
+		if(test_failing_allocations > 0)
+		{
+			test_failing_allocations--;
+			return NULL;
+		};
+		test_allocation_count++;
+		return malloc(sz);
+	};
+
+	static void platform_free(void *ptr)
+	{
+		test_allocation_count--;
+		free(ptr);
+	};
+
+//	Mandatory allocator
+	#include <stdlib.h>
+	#define lnklst_platform_alloc(sz)	platform_allocate(sz)
+	#define lnklst_platform_realloc(ptr, sz)	realloc(ptr, sz)
+	#define lnklst_platform_free(ptr)	platform_free(ptr)
+
+//	Optional thread safety
+	#define lnklst_mutex_lock(arg)		do{test_lock_count++;test_last_locked = (arg);}while(0)
+	#define lnklst_mutex_unlock(arg)	do{test_unlock_count++;}while(0)
+	#define lnklst_mutex_init(arg)		do{test_init_count++;}while(0)
+	#define lnklst_mutex_destroy(arg)	do{test_destroy_count++;}while(0)
+	#define lnklst_mutex_t				int
+
+//	Optional blocking queue, with no other threads every wait times out
+//	unless test_wait_hook is set, which is called as if by another thread while waiting, test_wait_hooks times
+//	a timed wait that is signalled by the hook ends half way, otherwise it takes all of its time on the test clock
+	int64_t test_clock = 0;
+	void (*test_wait_hook)(void*) = NULL;
+	void *test_wait_ctx = NULL;
+	int test_wait_hooks = 0;
+	int test_late_wakes = 0;	//the next timed waits time out even if signalled, as if the signal came just too late
+
+	static int test_timedwait(int ms)
+	{
+		int signals = test_signal_count + test_broadcast_count;
+		int late = test_late_wakes > 0;
+
+		test_wait_count++;
+		if(late)
+			test_late_wakes--;
+		if(test_wait_hook && test_wait_hooks)
+		{
+			test_wait_hooks--;
+			test_wait_hook(test_wait_ctx);
+		};
+		if(!late && signals != test_signal_count + test_broadcast_count)
+		{
+			test_clock += ms / 2;
+			return 0;
+		};
+		test_clock += ms;
+		return 1;
+	};
+
+	#define lnklst_clock_ms()						test_clock
+	#define lnklst_cond_init(arg)					((void)0)
+	#define lnklst_cond_destroy(arg)				((void)0)
+	#define lnklst_cond_wait(cond, mutex)			do{(void)(cond);(void)(mutex);test_wait_count++;}while(0)
+	#define lnklst_cond_timedwait(cond, mutex, ms)	((void)(cond), (void)(mutex), test_timedwait(ms))
+	#define lnklst_cond_signal(arg)					do{(void)(arg);test_signal_count++;}while(0)
+	#define lnklst_cond_broadcast(arg)				do{(void)(arg);test_broadcast_count++;}while(0)
+	#define lnklst_cond_t							int
+
+//	Optional threads for the parallel functions, which here run each "thread" to completion when it is joined
+	int test_thread_count = 0;
+	struct test_thread_struct
+	{
+		void*	(*func)(void*);
+		void	*arg;
+	};
+	#define lnklst_thread_create(thread, func_, arg_)	((thread)->func = (func_), (thread)->arg = (arg_), test_thread_count++, 0)
+	#define lnklst_thread_join(thread)					((void)(thread).func((thread).arg))
+	#define lnklst_thread_t								struct test_thread_struct
+
+	#define LNKLST_IMPLEMENTATION
+	#include "lnklst.h"
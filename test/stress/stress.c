@@ -0,0 +1,168 @@
+	#include <pthread.h>
+    #include <stdbool.h>
+    #include <stdlib.h>
+
+    #include "greatest.h"
+    #include "../../lnklst.h"
+
+//********************************************************************************************************
+// Local defines
+//********************************************************************************************************
+
+	GREATEST_MAIN_DEFS();
+
+    #define STRESS_READERS      3
+    #define STRESS_ROUNDS       20000
+    #define STRESS_LENGTH       200
+
+    //check is always ~value, so a reader can tell a torn or freed item from a live one
+    struct item
+    {
+        int value;
+        int check;
+    };
+
+    struct reader_struct
+    {
+        struct lnklst_struct *list;
+        int stop;           //set by the writer, read with atomics
+        long seen;
+        int bad;
+    };
+
+//********************************************************************************************************
+// Private prototypes
+//********************************************************************************************************
+
+	SUITE(suite_all_tests);
+
+    TEST test_stress_push_free(void);
+    TEST test_stress_remove(void);
+
+    static void* reader(void *arg);
+    static void push_item(struct lnklst_struct *list, int value);
+    static bool is_multiple_of_3(void *allocation, void *ctx);
+
+//********************************************************************************************************
+// Public functions
+//********************************************************************************************************
+
+int main(int argc, const char* argv[])
+{
+	GREATEST_MAIN_BEGIN();
+	RUN_SUITE(suite_all_tests);
+	GREATEST_MAIN_END();
+
+	return 0;
+}
+
+//********************************************************************************************************
+// Private functions
+//********************************************************************************************************
+
+SUITE(suite_all_tests)
+{
+    RUN_TEST(test_stress_push_free);
+    RUN_TEST(test_stress_remove);
+}
+
+// readers walk both ways while the writer pushes, frees and re-allocates under them
+TEST test_stress_push_free(void)
+{
+    struct reader_struct ctx = {lnklst_create(), 0, 0, 0};
+    pthread_t threads[STRESS_READERS];
+    struct item *x;
+    int i;
+
+    for(i = 0; i < STRESS_LENGTH; i++)
+        push_item(ctx.list, i);
+    for(i = 0; i < STRESS_READERS; i++)
+        pthread_create(&threads[i], NULL, reader, &ctx);
+
+    for(i = STRESS_LENGTH; i < STRESS_ROUNDS; i++)
+    {
+        push_item(ctx.list, i);
+        lnklst_free(ctx.list, lnklst_first(ctx.list));
+        if(!(i % 7))
+        {
+            x = lnklst_index(ctx.list, STRESS_LENGTH / 2);
+            x = lnklst_reallocate(ctx.list, x, sizeof(struct item) * 2);
+            ASSERT(x->check == ~x->value);
+        };
+    };
+
+    __atomic_store_n(&ctx.stop, 1, __ATOMIC_RELEASE);
+    for(i = 0; i < STRESS_READERS; i++)
+        pthread_join(threads[i], NULL);
+    ASSERT(ctx.seen > 0);
+    ASSERT(ctx.bad == 0);
+    ASSERT(lnklst_count(ctx.list) == STRESS_LENGTH);
+    lnklst_destroy(&ctx.list);
+    PASS();
+}
+
+// readers walk while two writers refill the list, and strip it with lnklst_remove_if() and lnklst_pop_front()
+TEST test_stress_remove(void)
+{
+    struct reader_struct ctx = {lnklst_create(), 0, 0, 0};
+    pthread_t threads[STRESS_READERS];
+    int i, j;
+
+    for(i = 0; i < STRESS_READERS; i++)
+        pthread_create(&threads[i], NULL, reader, &ctx);
+
+    for(i = 0; i < STRESS_ROUNDS / STRESS_LENGTH; i++)
+    {
+        for(j = 0; j < STRESS_LENGTH; j++)
+            push_item(ctx.list, j);
+        lnklst_remove_if(ctx.list, is_multiple_of_3, NULL);
+        while(lnklst_pop_front(ctx.list, NULL, sizeof(struct item)))
+            ;
+    };
+
+    __atomic_store_n(&ctx.stop, 1, __ATOMIC_RELEASE);
+    for(i = 0; i < STRESS_READERS; i++)
+        pthread_join(threads[i], NULL);
+    ASSERT(ctx.bad == 0);
+    ASSERT(lnklst_count(ctx.list) == 0);
+    lnklst_destroy(&ctx.list);
+    PASS();
+}
+
+//walk the list forwards then backwards inside a read-side section, until the writer is done
+static void* reader(void *arg)
+{
+    struct reader_struct *ctx = arg;
+    struct item *x;
+    long seen = 0;
+    int bad = 0;
+    int token;
+
+    while(!__atomic_load_n(&ctx->stop, __ATOMIC_ACQUIRE))
+    {
+        token = lnklst_read_enter(ctx->list);
+        for(x = lnklst_read_first(ctx->list); x; x = lnklst_read_after(ctx->list, x), seen++)
+            bad += x->check != ~x->value;
+        for(x = lnklst_read_last(ctx->list); x; x = lnklst_read_before(ctx->list, x), seen++)
+            bad += x->check != ~x->value;
+        lnklst_read_exit(ctx->list, token);
+    };
+
+    //each reader adds its own totals once it has finished
+    __atomic_add_fetch(&ctx->seen, seen, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ctx->bad, bad, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void push_item(struct lnklst_struct *list, int value)
+{
+    struct item x = {value, ~value};
+
+    lnklst_push_back(list, &x, sizeof(x));
+}
+
+static bool is_multiple_of_3(void *allocation, void *ctx)
+{
+    (void)ctx;
+    return !(((struct item*)allocation)->value % 3);
+}
@@ -1,398 +1,2475 @@
-
-	#include <stdio.h>
-    #include <stdlib.h>
-
-    #include "greatest.h"
-    #include "../lnklst.h"
-
-//********************************************************************************************************
-// Local defines
-//********************************************************************************************************
-
-	GREATEST_MAIN_DEFS();
-
-	extern int test_lock_count;
-	extern int test_unlock_count;
-	extern int test_init_count;
-	extern int test_destroy_count;
-    extern int test_allocation_count;
-
-//********************************************************************************************************
-// Public variables 
-//********************************************************************************************************
-
-//********************************************************************************************************
-// Private variables
-//********************************************************************************************************
-
-//********************************************************************************************************
-// Private prototypes
-//********************************************************************************************************
-
-    static void reset_stats(void);
-
-
-	SUITE(suite_all_tests);
-
-    TEST test_lnklst_create(void);
-    TEST test_lnklst_destroy(void);
-    TEST test_lnklst_allocate(void);
-    TEST test_lnklst_reallocate(void);
-    TEST test_lnklst_free(void);
-    TEST test_lnklst_before(void);
-    TEST test_lnklst_after(void);
-    TEST test_lnklst_last(void);
-    TEST test_lnklst_first(void);
-    TEST test_lnklst_index(void);
-    TEST test_lnklst_sort(void);
-    TEST test_lnklst_count(void);
-    TEST test_gen_linked_list(void);
-
-    static int swapfunc(void *a, void *b);
-
-//********************************************************************************************************
-// Public functions
-//********************************************************************************************************
-
-int main(int argc, const char* argv[])
-{
-	GREATEST_MAIN_BEGIN();
-	RUN_SUITE(suite_all_tests);
-	GREATEST_MAIN_END();
-
-	return 0;
-}
-
-//********************************************************************************************************
-// Private functions
-//********************************************************************************************************
-
-SUITE(suite_all_tests)
-{
-    RUN_TEST(test_lnklst_create);
-    RUN_TEST(test_lnklst_destroy);
-    RUN_TEST(test_lnklst_allocate);
-    RUN_TEST(test_lnklst_reallocate);
-    RUN_TEST(test_lnklst_free);
-    RUN_TEST(test_lnklst_before);
-    RUN_TEST(test_lnklst_after);
-    RUN_TEST(test_lnklst_last);
-    RUN_TEST(test_lnklst_first);
-    RUN_TEST(test_lnklst_index);
-    RUN_TEST(test_lnklst_sort);
-    RUN_TEST(test_lnklst_count);
-}
-
-TEST test_lnklst_create(void)
-{
-    struct lnklst_struct *list;
-    test_init_count = 0;
-    test_allocation_count = 0;
-    list = lnklst_create();
-    ASSERT(list);
-    ASSERT(test_init_count == 1);
-    ASSERT(test_allocation_count == 1);
-    ASSERT(lnklst_count(list) == 0);
-    ASSERT(lnklst_first(list) == NULL);
-    ASSERT(lnklst_last(list) == NULL);
-    ASSERT(lnklst_index(list,0) == NULL);
-    lnklst_destroy(&list);
-    PASS();
-}
-
-TEST test_lnklst_destroy(void)
-{
-    struct lnklst_struct *list;
-
-    list = lnklst_create();
-    reset_stats();
-    lnklst_destroy(&list);
-    ASSERT(test_allocation_count == -1);
-    ASSERT(test_lock_count == 1);
-    ASSERT(test_unlock_count == 1);
-    ASSERT(test_destroy_count == 1);
-
-    list = lnklst_create();
-    lnklst_allocate(list, rand()%1024);
-
-    reset_stats();
-    lnklst_destroy(&list);
-    ASSERT(test_allocation_count == -2);
-    ASSERT(test_lock_count == 1);
-    ASSERT(test_unlock_count == 1);
-    ASSERT(test_destroy_count == 1);
-
-    list = lnklst_create();
-    lnklst_allocate(list, rand()%1024);
-    lnklst_allocate(list, rand()%1024);
-
-    reset_stats();
-    lnklst_destroy(&list);
-    ASSERT(test_allocation_count == -3);
-    ASSERT(test_lock_count == 1);
-    ASSERT(test_unlock_count == 1);
-    ASSERT(test_destroy_count == 1);
-
-    PASS();
-}
-
-TEST test_lnklst_allocate(void)
-{
-    struct lnklst_struct *list;
-    void *ptr;
-    list = lnklst_create();
-    size_t sz = rand()%1024;
-
-    reset_stats();
-
-    ptr = lnklst_allocate(list, sz);
-    memset(ptr, 0xFF, sz);
-    ASSERT(lnklst_count(list) == 1);        //(also locks)
-    ASSERT(test_allocation_count == 1);
-    ASSERT(test_lock_count == 2);
-    ASSERT(test_unlock_count == 2);
-
-    ptr = lnklst_allocate(list, sz);
-    memset(ptr, 0xFF, sz);
-    ASSERT(lnklst_count(list) == 2);
-    ASSERT(test_allocation_count == 2);
-    ASSERT(test_lock_count == 4);
-    ASSERT(test_unlock_count == 4);
-    lnklst_destroy(&list);
-
-    PASS();
-}
-
-TEST test_lnklst_reallocate(void)
-{
-    struct lnklst_struct *list;
-    void *a, *b, *c;
- 
-    // test reallocating the middle of 3 allocations
-    list = lnklst_create();
- 
-    a = lnklst_allocate(list, 8);
-    b = lnklst_allocate(list, 8);
-    c = lnklst_allocate(list, 8);
-
-    reset_stats();
-    strcpy(b, "1234567");
-    b = lnklst_reallocate(list, b, 524288);
-    ASSERT(!strcmp(b, "1234567"));
-
-    ASSERT(lnklst_count(list) == 3);        //(also locks)
-    ASSERT(test_lock_count == 2);
-    ASSERT(test_unlock_count == 2);
-
-    ASSERT(lnklst_after(list, a) == b);
-    ASSERT(lnklst_before(list, c) == b);
-
-    lnklst_destroy(&list);
- 
-
-    // test reallocating a single allocations (so there is no before link)
-    list = lnklst_create();
-    a = lnklst_allocate(list, 8);
-
-    reset_stats();
-    strcpy(a, "1234567");
-    a = lnklst_reallocate(list, a, 524288);
-
-    ASSERT(!strcmp(a, "1234567"));
-    ASSERT(lnklst_count(list) == 1);        //(also locks)
-    ASSERT(test_lock_count == 2);
-    ASSERT(test_unlock_count == 2);
-
-    ASSERT(lnklst_index(list, 0) == a);
-
-    lnklst_destroy(&list);
-
-    PASS();
-}
-
-TEST test_lnklst_free(void)
-{
-    struct lnklst_struct *list = lnklst_create();
-
-    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 4;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 5;
-    ASSERT(lnklst_count(list) == 5);
-
-    reset_stats();
-    lnklst_free(list, lnklst_last(list));       //free last
-    ASSERT(test_allocation_count == -1);
-    ASSERT(test_lock_count == 2);
-    ASSERT(test_unlock_count == 2);
-    ASSERT(lnklst_count(list) == 4);
-    ASSERT(*(int*)lnklst_last(list) == 4);
-
-    reset_stats();
-    lnklst_free(list, lnklst_first(list));      //free first
-    ASSERT(test_allocation_count == -1);
-    ASSERT(test_lock_count == 2);
-    ASSERT(test_unlock_count == 2);
-    ASSERT(lnklst_count(list) == 3);
-    ASSERT(*(int*)lnklst_first(list) == 2);
-    
-
-    reset_stats();
-    lnklst_free(list, lnklst_index(list, 1));   //free middle
-    ASSERT(test_allocation_count == -1);
-    ASSERT(test_lock_count == 2);
-    ASSERT(test_unlock_count == 2);
-    ASSERT(lnklst_count(list) == 2);
-    ASSERT(*(int*)lnklst_index(list, 0) == 2);
-    ASSERT(*(int*)lnklst_index(list, 1) == 4);
-
-    lnklst_destroy(&list);
-    PASS();
-}
-
-TEST test_lnklst_before(void)
-{
-    struct lnklst_struct *list = lnklst_create();
-    int *ptr;
-
-    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
-    ptr = lnklst_allocate(list, sizeof(int));
-    *ptr = 2;
-
-    reset_stats();
-    ASSERT(*(int*)lnklst_before(list, ptr) == 1);
-    ASSERT(test_lock_count == 1);
-    ASSERT(test_unlock_count == 1);
-
-    lnklst_destroy(&list);
-    PASS();
-}
-
-TEST test_lnklst_after(void)
-{
-    struct lnklst_struct *list = lnklst_create();
-    int *ptr;
-
-    ptr = lnklst_allocate(list, sizeof(int));
-    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
-    *ptr = 1;
-
-    reset_stats();
-    ASSERT(*(int*)lnklst_after(list, ptr) == 2);
-    ASSERT(test_lock_count == 1);
-    ASSERT(test_unlock_count == 1);
-
-    lnklst_destroy(&list);
-    PASS();
-}
-
-TEST test_lnklst_last(void)
-{
-    struct lnklst_struct *list = lnklst_create();
-    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
-
-    reset_stats();
-    ASSERT(*(int*)lnklst_last(list) == 3);
-
-    lnklst_destroy(&list);
-    PASS();
-}
-
-TEST test_lnklst_first(void)
-{
-    struct lnklst_struct *list = lnklst_create();
-    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
-
-    reset_stats();
-    ASSERT(*(int*)lnklst_first(list) == 1);
-
-    lnklst_destroy(&list);
-    PASS();
-}
-
-TEST test_lnklst_index(void)
-{
-    struct lnklst_struct *list = lnklst_create();
-    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 4;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 5;
-
-    reset_stats();
-    ASSERT(*(int*)lnklst_index(list,0) == 1);
-    ASSERT(*(int*)lnklst_index(list,1) == 2);
-    ASSERT(*(int*)lnklst_index(list,2) == 3);
-    ASSERT(*(int*)lnklst_index(list,3) == 4);
-    ASSERT(*(int*)lnklst_index(list,4) == 5);
-
-    ASSERT(test_lock_count == 5);
-    ASSERT(test_unlock_count == 5);
-
-    ASSERT(lnklst_index(list,5) == NULL);
-    ASSERT(lnklst_index(list,-1) == NULL);
-
-    lnklst_destroy(&list);
-    PASS();
-}
-
-TEST test_lnklst_sort(void)
-{
-    struct lnklst_struct *list = lnklst_create();
-
-    *(int*)lnklst_allocate(list, sizeof(int)) = 5;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
-    *(int*)lnklst_allocate(list, sizeof(int)) = 4;
-
-    reset_stats();
-    lnklst_sort(list, swapfunc);
-
-    ASSERT(test_lock_count == 1);
-    ASSERT(test_unlock_count == 1);
-
-    ASSERT(*(int*)lnklst_index(list,0) == 1);
-    ASSERT(*(int*)lnklst_index(list,1) == 2);
-    ASSERT(*(int*)lnklst_index(list,2) == 3);
-    ASSERT(*(int*)lnklst_index(list,3) == 4);
-    ASSERT(*(int*)lnklst_index(list,4) == 5);
-
-    lnklst_destroy(&list);
-    PASS();
-}
-
-TEST test_lnklst_count(void)
-{
-    struct lnklst_struct *list = lnklst_create();
-
-    ASSERT(lnklst_count(list) == 0);
-    lnklst_allocate(list, sizeof(int));
-    reset_stats();
-    ASSERT(lnklst_count(list) == 1);
-    ASSERT(test_lock_count == 1);
-    ASSERT(test_unlock_count == 1);
-
-    lnklst_destroy(&list);
-    PASS();
-}
-
-static void reset_stats(void)
-{
-    test_lock_count = 0;
-    test_unlock_count = 0;
-    test_init_count = 0;
-    test_destroy_count = 0;
-    test_allocation_count = 0;
-}
-
-static int swapfunc(void *a, void *b)
-{
-    return *(int*)a - *(int*)b;
-}
-
+
+	#include <stdio.h>
+    #include <stdlib.h>
+    #include <sys/mman.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+
+    #include "greatest.h"
+    #include "../lnklst.h"
+
+//********************************************************************************************************
+// Local defines
+//********************************************************************************************************
+
+	GREATEST_MAIN_DEFS();
+
+	extern int test_lock_count;
+	extern int test_unlock_count;
+	extern int test_init_count;
+	extern int test_destroy_count;
+    extern int test_allocation_count;
+    extern int test_wait_count;
+    extern int test_signal_count;
+    extern int test_broadcast_count;
+    extern int test_thread_count;
+    extern int64_t test_clock;
+    extern void (*test_wait_hook)(void*);
+    extern void *test_wait_ctx;
+    extern int test_wait_hooks;
+    extern int test_late_wakes;
+    extern const void *test_last_locked;
+
+    struct point
+    {
+        int x;
+        int y;
+    };
+
+    LNKLST_DEFINE_TYPED(points, struct point, (a->x > b->x) - (a->x < b->x))
+
+//********************************************************************************************************
+// Public variables 
+//********************************************************************************************************
+
+//********************************************************************************************************
+// Private variables
+//********************************************************************************************************
+
+//********************************************************************************************************
+// Private prototypes
+//********************************************************************************************************
+
+    static void reset_stats(void);
+
+
+	SUITE(suite_all_tests);
+
+    TEST test_lnklst_create(void);
+    TEST test_lnklst_destroy(void);
+    TEST test_lnklst_allocate(void);
+    TEST test_lnklst_reallocate(void);
+    TEST test_lnklst_free(void);
+    TEST test_lnklst_before(void);
+    TEST test_lnklst_after(void);
+    TEST test_lnklst_last(void);
+    TEST test_lnklst_first(void);
+    TEST test_lnklst_index(void);
+    TEST test_lnklst_index_finger(void);
+    TEST test_lnklst_sort(void);
+    TEST test_lnklst_count(void);
+    TEST test_lnklst_push_pop(void);
+    TEST test_lnklst_peek(void);
+    TEST test_lnklst_push_wait(void);
+    TEST test_lnklst_pop_wait(void);
+    TEST test_lnklst_close(void);
+    TEST test_lnklst_detach_all(void);
+    TEST test_lnklst_remove_if(void);
+    TEST test_lnklst_partition(void);
+    TEST test_lnklst_compact(void);
+    TEST test_lnklst_lru(void);
+    TEST test_lnklst_unrolled(void);
+    TEST test_lnklst_unrolled_free(void);
+    TEST test_lnklst_unrolled_sort(void);
+    TEST test_lnklst_destroy_async(void);
+    #ifdef LNKLST_EPOCH
+    TEST test_lnklst_read(void);
+    TEST test_lnklst_snapshot(void);
+    #endif
+    TEST test_lnklst_save_load(void);
+    TEST test_lnklst_shm(void);
+    TEST test_lnklst_shm_fork(void);
+    TEST test_lnklst_allocator(void);
+    TEST test_lnklst_reorder(void);
+    TEST test_lnklst_typed(void);
+    TEST test_lnklst_allocate_aligned(void);
+    TEST test_lnklst_arena(void);
+    TEST test_lnklst_parallel(void);
+    TEST test_lnklst_pool(void);
+    TEST test_lnklst_find(void);
+    TEST test_lnklst_merge_sorted(void);
+    TEST test_lnklst_top_k(void);
+    TEST test_lnklst_sort_incremental(void);
+    TEST test_lnklst_queue_wake(void);
+    TEST test_gen_linked_list(void);
+
+    static int swapfunc(void *a, void *b);
+    static bool is_odd(void *allocation, void *ctx);
+    static bool less_than(void *allocation, void *ctx);
+    static int counted_swapfunc(void *a, void *b);
+    static void push_one(void *ctx);
+    static void push_and_take(void *ctx);
+    static void take_one(void *ctx);
+    static void relocfunc(void *old, void *new, void *ctx);
+    static void* lru_keyfunc(void *entry);
+    static uint32_t lru_hashfunc(void *key);
+    static int lru_keycmp(void *a, void *b);
+    static void lru_evictfunc(void *entry);
+    static bool stream_write(const void *src, size_t len, void *ctx);
+    static bool stream_read(void *dst, size_t len, void *ctx);
+    static void* counting_alloc(size_t size, void *ctx);
+    static void* counting_realloc(void *ptr, size_t size, void *ctx);
+    static void counting_free(void *ptr, void *ctx);
+    static void* skewed_alloc(size_t size, void *ctx);
+    static void* skewed_realloc(void *ptr, size_t size, void *ctx);
+    static void skewed_free(void *ptr, void *ctx);
+    static void add_to(void *allocation, void *ctx);
+    static void sum_map(void *acc, void *allocation);
+    static void sum_combine(void *acc, void *other);
+
+    static int swapfunc_calls;
+    static int lru_evict_count;
+    static int skewed_overruns;
+
+    #define SKEW_GUARD  16
+
+    //arena chunks are mapped directly in these builds, so the platform allocation count doesn't see them
+    #if defined(LNKLST_HUGEPAGES) || defined(LNKLST_NUMA)
+    #define ASSERT_CHUNKS(cond)
+    #else
+    #define ASSERT_CHUNKS(cond) ASSERT(cond)
+    #endif
+
+    //precedes each block from the skewed allocator
+    struct skewed_prefix
+    {
+        void *block;
+        size_t size;
+    };
+
+    struct stream_struct
+    {
+        uint8_t *data;
+        size_t length;
+        size_t position;
+    };
+
+//********************************************************************************************************
+// Public functions
+//********************************************************************************************************
+
+int main(int argc, const char* argv[])
+{
+	GREATEST_MAIN_BEGIN();
+	RUN_SUITE(suite_all_tests);
+	GREATEST_MAIN_END();
+
+	return 0;
+}
+
+//********************************************************************************************************
+// Private functions
+//********************************************************************************************************
+
+SUITE(suite_all_tests)
+{
+    RUN_TEST(test_lnklst_create);
+    RUN_TEST(test_lnklst_destroy);
+    RUN_TEST(test_lnklst_allocate);
+    RUN_TEST(test_lnklst_reallocate);
+    RUN_TEST(test_lnklst_free);
+    RUN_TEST(test_lnklst_before);
+    RUN_TEST(test_lnklst_after);
+    RUN_TEST(test_lnklst_last);
+    RUN_TEST(test_lnklst_first);
+    RUN_TEST(test_lnklst_index);
+    RUN_TEST(test_lnklst_index_finger);
+    RUN_TEST(test_lnklst_sort);
+    RUN_TEST(test_lnklst_count);
+    RUN_TEST(test_lnklst_push_pop);
+    RUN_TEST(test_lnklst_peek);
+    RUN_TEST(test_lnklst_push_wait);
+    RUN_TEST(test_lnklst_pop_wait);
+    RUN_TEST(test_lnklst_close);
+    RUN_TEST(test_lnklst_detach_all);
+    RUN_TEST(test_lnklst_remove_if);
+    RUN_TEST(test_lnklst_partition);
+    RUN_TEST(test_lnklst_compact);
+    RUN_TEST(test_lnklst_lru);
+    RUN_TEST(test_lnklst_unrolled);
+    RUN_TEST(test_lnklst_unrolled_free);
+    RUN_TEST(test_lnklst_unrolled_sort);
+    RUN_TEST(test_lnklst_destroy_async);
+    #ifdef LNKLST_EPOCH
+    RUN_TEST(test_lnklst_read);
+    RUN_TEST(test_lnklst_snapshot);
+    #endif
+    RUN_TEST(test_lnklst_save_load);
+    RUN_TEST(test_lnklst_shm);
+    RUN_TEST(test_lnklst_shm_fork);
+    RUN_TEST(test_lnklst_allocator);
+    RUN_TEST(test_lnklst_reorder);
+    RUN_TEST(test_lnklst_typed);
+    RUN_TEST(test_lnklst_allocate_aligned);
+    RUN_TEST(test_lnklst_arena);
+    RUN_TEST(test_lnklst_parallel);
+    RUN_TEST(test_lnklst_pool);
+    RUN_TEST(test_lnklst_find);
+    RUN_TEST(test_lnklst_merge_sorted);
+    RUN_TEST(test_lnklst_top_k);
+    RUN_TEST(test_lnklst_sort_incremental);
+    RUN_TEST(test_lnklst_queue_wake);
+}
+
+TEST test_lnklst_create(void)
+{
+    struct lnklst_struct *list;
+    test_init_count = 0;
+    test_allocation_count = 0;
+    list = lnklst_create();
+    ASSERT(list);
+    ASSERT(test_init_count == 1);
+    ASSERT(test_allocation_count == 1);
+    ASSERT(lnklst_count(list) == 0);
+    ASSERT(lnklst_first(list) == NULL);
+    ASSERT(lnklst_last(list) == NULL);
+    ASSERT(lnklst_index(list,0) == NULL);
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_destroy(void)
+{
+    struct lnklst_struct *list;
+
+    list = lnklst_create();
+    reset_stats();
+    lnklst_destroy(&list);
+    ASSERT(test_allocation_count == -1);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_unlock_count == 1);
+    ASSERT(test_destroy_count == 1);
+
+    list = lnklst_create();
+    lnklst_allocate(list, rand()%1024);
+
+    reset_stats();
+    lnklst_destroy(&list);
+    ASSERT(test_allocation_count == -2);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_unlock_count == 1);
+    ASSERT(test_destroy_count == 1);
+
+    list = lnklst_create();
+    lnklst_allocate(list, rand()%1024);
+    lnklst_allocate(list, rand()%1024);
+
+    reset_stats();
+    lnklst_destroy(&list);
+    ASSERT(test_allocation_count == -3);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_unlock_count == 1);
+    ASSERT(test_destroy_count == 1);
+
+    PASS();
+}
+
+TEST test_lnklst_allocate(void)
+{
+    struct lnklst_struct *list;
+    void *ptr;
+    list = lnklst_create();
+    size_t sz = rand()%1024;
+
+    reset_stats();
+
+    ptr = lnklst_allocate(list, sz);
+    memset(ptr, 0xFF, sz);
+    ASSERT(lnklst_count(list) == 1);        //(also locks)
+    ASSERT(test_allocation_count == 1);
+    ASSERT(test_lock_count == 2);
+    ASSERT(test_unlock_count == 2);
+
+    ptr = lnklst_allocate(list, sz);
+    memset(ptr, 0xFF, sz);
+    ASSERT(lnklst_count(list) == 2);
+    ASSERT(test_allocation_count == 2);
+    ASSERT(test_lock_count == 4);
+    ASSERT(test_unlock_count == 4);
+    lnklst_destroy(&list);
+
+    PASS();
+}
+
+TEST test_lnklst_reallocate(void)
+{
+    struct lnklst_struct *list;
+    void *a, *b, *c;
+ 
+    // test reallocating the middle of 3 allocations
+    list = lnklst_create();
+ 
+    a = lnklst_allocate(list, 8);
+    b = lnklst_allocate(list, 8);
+    c = lnklst_allocate(list, 8);
+
+    reset_stats();
+    strcpy(b, "1234567");
+    b = lnklst_reallocate(list, b, 524288);
+    ASSERT(!strcmp(b, "1234567"));
+
+    ASSERT(lnklst_count(list) == 3);        //(also locks)
+    ASSERT(test_lock_count == 2);
+    ASSERT(test_unlock_count == 2);
+
+    ASSERT(lnklst_after(list, a) == b);
+    ASSERT(lnklst_before(list, c) == b);
+
+    lnklst_destroy(&list);
+ 
+
+    // test reallocating a single allocations (so there is no before link)
+    list = lnklst_create();
+    a = lnklst_allocate(list, 8);
+
+    reset_stats();
+    strcpy(a, "1234567");
+    a = lnklst_reallocate(list, a, 524288);
+
+    ASSERT(!strcmp(a, "1234567"));
+    ASSERT(lnklst_count(list) == 1);        //(also locks)
+    ASSERT(test_lock_count == 2);
+    ASSERT(test_unlock_count == 2);
+
+    ASSERT(lnklst_index(list, 0) == a);
+
+    lnklst_destroy(&list);
+
+    PASS();
+}
+
+TEST test_lnklst_free(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+
+    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 4;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 5;
+    ASSERT(lnklst_count(list) == 5);
+
+    reset_stats();
+    lnklst_free(list, lnklst_last(list));       //free last
+    ASSERT(test_allocation_count == -1);
+    ASSERT(test_lock_count == 2);
+    ASSERT(test_unlock_count == 2);
+    ASSERT(lnklst_count(list) == 4);
+    ASSERT(*(int*)lnklst_last(list) == 4);
+
+    reset_stats();
+    lnklst_free(list, lnklst_first(list));      //free first
+    ASSERT(test_allocation_count == -1);
+    ASSERT(test_lock_count == 2);
+    ASSERT(test_unlock_count == 2);
+    ASSERT(lnklst_count(list) == 3);
+    ASSERT(*(int*)lnklst_first(list) == 2);
+    
+
+    reset_stats();
+    lnklst_free(list, lnklst_index(list, 1));   //free middle
+    ASSERT(test_allocation_count == -1);
+    ASSERT(test_lock_count == 2);
+    ASSERT(test_unlock_count == 2);
+    ASSERT(lnklst_count(list) == 2);
+    ASSERT(*(int*)lnklst_index(list, 0) == 2);
+    ASSERT(*(int*)lnklst_index(list, 1) == 4);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_before(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int *ptr;
+
+    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
+    ptr = lnklst_allocate(list, sizeof(int));
+    *ptr = 2;
+
+    reset_stats();
+    ASSERT(*(int*)lnklst_before(list, ptr) == 1);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_unlock_count == 1);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_after(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int *ptr;
+
+    ptr = lnklst_allocate(list, sizeof(int));
+    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
+    *ptr = 1;
+
+    reset_stats();
+    ASSERT(*(int*)lnklst_after(list, ptr) == 2);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_unlock_count == 1);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_last(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
+
+    reset_stats();
+    ASSERT(*(int*)lnklst_last(list) == 3);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_first(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
+
+    reset_stats();
+    ASSERT(*(int*)lnklst_first(list) == 1);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_index(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 4;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 5;
+
+    reset_stats();
+    ASSERT(*(int*)lnklst_index(list,0) == 1);
+    ASSERT(*(int*)lnklst_index(list,1) == 2);
+    ASSERT(*(int*)lnklst_index(list,2) == 3);
+    ASSERT(*(int*)lnklst_index(list,3) == 4);
+    ASSERT(*(int*)lnklst_index(list,4) == 5);
+
+    ASSERT(test_lock_count == 5);
+    ASSERT(test_unlock_count == 5);
+
+    ASSERT(lnklst_index(list,5) == NULL);
+    ASSERT(lnklst_index(list,-1) == NULL);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_index_finger(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int i;
+
+    for(i=0; i<100; i++)
+        *(int*)lnklst_allocate(list, sizeof(int)) = i;
+
+    // sequential, reverse and scattered
+    for(i=0; i<100; i++)
+        ASSERT(*(int*)lnklst_index(list,i) == i);
+    for(i=99; i>=0; i--)
+        ASSERT(*(int*)lnklst_index(list,i) == i);
+    for(i=0; i<100; i++)
+        ASSERT(*(int*)lnklst_index(list,(i*37)%100) == (i*37)%100);
+
+    // mutations around the finger
+    ASSERT(*(int*)lnklst_index(list,50) == 50);
+    lnklst_free(list, lnklst_first(list));
+    ASSERT(*(int*)lnklst_index(list,50) == 51);
+    lnklst_free(list, lnklst_last(list));
+    ASSERT(*(int*)lnklst_index(list,50) == 51);
+    i = -1;
+    lnklst_push_front(list, &i, sizeof(int));
+    ASSERT(*(int*)lnklst_index(list,51) == 51);
+    lnklst_free(list, lnklst_index(list,20));
+    ASSERT(*(int*)lnklst_index(list,51) == 52);
+    lnklst_free(list, lnklst_index(list,51));
+    ASSERT(*(int*)lnklst_index(list,51) == 53);
+    *(int*)lnklst_allocate(list, sizeof(int)) = 100;
+    ASSERT(*(int*)lnklst_index(list,51) == 53);
+    ASSERT(*(int*)lnklst_index(list,lnklst_count(list)-1) == 100);
+    lnklst_pop_back(list, NULL, sizeof(int));
+    lnklst_pop_front(list, NULL, sizeof(int));
+    ASSERT(*(int*)lnklst_index(list,0) == 1);
+    ASSERT(*(int*)lnklst_index(list,95) == 98);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_sort(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+
+    *(int*)lnklst_allocate(list, sizeof(int)) = 5;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 4;
+
+    reset_stats();
+    lnklst_sort(list, swapfunc);
+
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_unlock_count == 1);
+
+    ASSERT(*(int*)lnklst_index(list,0) == 1);
+    ASSERT(*(int*)lnklst_index(list,1) == 2);
+    ASSERT(*(int*)lnklst_index(list,2) == 3);
+    ASSERT(*(int*)lnklst_index(list,3) == 4);
+    ASSERT(*(int*)lnklst_index(list,4) == 5);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_count(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+
+    ASSERT(lnklst_count(list) == 0);
+    lnklst_allocate(list, sizeof(int));
+    reset_stats();
+    ASSERT(lnklst_count(list) == 1);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_unlock_count == 1);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_push_pop(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int value;
+
+    value = 2;
+    ASSERT(*(int*)lnklst_push_back(list, &value, sizeof(int)) == 2);
+    value = 3;
+    lnklst_push_back(list, &value, sizeof(int));
+    value = 1;
+    ASSERT(*(int*)lnklst_push_front(list, &value, sizeof(int)) == 1);
+    value = 0;
+    lnklst_push_front(list, &value, sizeof(int));
+
+    ASSERT(lnklst_count(list) == 4);
+    ASSERT(*(int*)lnklst_index(list,0) == 0);
+    ASSERT(*(int*)lnklst_index(list,1) == 1);
+    ASSERT(*(int*)lnklst_index(list,2) == 2);
+    ASSERT(*(int*)lnklst_index(list,3) == 3);
+    ASSERT(lnklst_before(list, lnklst_first(list)) == NULL);
+    ASSERT(*(int*)lnklst_before(list, lnklst_index(list,1)) == 0);
+
+    reset_stats();
+    ASSERT(lnklst_pop_front(list, &value, sizeof(int)));
+    ASSERT(value == 0);
+    ASSERT(test_allocation_count == -1);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_unlock_count == 1);
+
+    ASSERT(lnklst_pop_back(list, &value, sizeof(int)));
+    ASSERT(value == 3);
+    ASSERT(lnklst_pop_front(list, NULL, sizeof(int)));
+    ASSERT(*(int*)lnklst_first(list) == 2);
+    ASSERT(*(int*)lnklst_last(list) == 2);
+    ASSERT(lnklst_pop_back(list, &value, sizeof(int)));
+    ASSERT(value == 2);
+
+    ASSERT(lnklst_count(list) == 0);
+    ASSERT(!lnklst_pop_front(list, &value, sizeof(int)));
+    ASSERT(!lnklst_pop_back(list, &value, sizeof(int)));
+    ASSERT(lnklst_first(list) == NULL);
+    ASSERT(lnklst_last(list) == NULL);
+
+    // push front into an empty list
+    value = 5;
+    lnklst_push_front(list, &value, sizeof(int));
+    ASSERT(*(int*)lnklst_first(list) == 5);
+    ASSERT(*(int*)lnklst_last(list) == 5);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_peek(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int value = 0;
+
+    ASSERT(!lnklst_peek_front(list, &value, sizeof(int)));
+    ASSERT(!lnklst_peek_back(list, &value, sizeof(int)));
+
+    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
+
+    reset_stats();
+    ASSERT(lnklst_peek_front(list, &value, sizeof(int)));
+    ASSERT(value == 1);
+    ASSERT(lnklst_peek_back(list, &value, sizeof(int)));
+    ASSERT(value == 2);
+    ASSERT(test_lock_count == 2);
+    ASSERT(test_allocation_count == 0);
+    ASSERT(lnklst_count(list) == 2);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_push_wait(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int values[3] = {1, 2, 3};
+
+    lnklst_set_capacity(list, 2);
+
+    reset_stats();
+    ASSERT(lnklst_push_wait(list, &values[0], sizeof(int), 10));
+    ASSERT(lnklst_push_wait(list, &values[1], sizeof(int), 10));
+    ASSERT(test_wait_count == 0);
+    ASSERT(test_lock_count == 2);
+
+    // full, times out after one wait
+    ASSERT(!lnklst_push_wait(list, &values[2], sizeof(int), 10));
+    ASSERT(test_wait_count == 1);
+    // full, no timeout so no wait
+    ASSERT(!lnklst_push_wait(list, &values[2], sizeof(int), 0));
+    ASSERT(test_wait_count == 1);
+    ASSERT(lnklst_count(list) == 2);
+
+    // partial batch
+    ASSERT(lnklst_pop_front(list, NULL, sizeof(int)));
+    ASSERT(lnklst_push_wait_many(list, values, sizeof(int), 3, 10) == 1);
+    ASSERT(*(int*)lnklst_index(list,0) == 2);
+    ASSERT(*(int*)lnklst_index(list,1) == 1);
+
+    // no waiting consumers, so nobody to wake
+    ASSERT(test_signal_count == 0);
+    ASSERT(test_broadcast_count == 0);
+
+    // no limit
+    lnklst_set_capacity(list, 0);
+    ASSERT(lnklst_push_wait_many(list, values, sizeof(int), 3, 0) == 3);
+    ASSERT(lnklst_count(list) == 5);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_pop_wait(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int values[3] = {1, 2, 3};
+    int out[4] = {0};
+
+    reset_stats();
+    ASSERT(!lnklst_pop_wait(list, out, sizeof(int), 0));
+    ASSERT(test_wait_count == 0);
+    ASSERT(!lnklst_pop_wait(list, out, sizeof(int), 10));
+    ASSERT(test_wait_count == 1);
+
+    lnklst_push_wait_many(list, values, sizeof(int), 3, 0);
+    reset_stats();
+    ASSERT(lnklst_pop_wait(list, out, sizeof(int), 10));
+    ASSERT(out[0] == 1);
+    ASSERT(test_allocation_count == -1);
+    ASSERT(test_lock_count == 1);
+
+    ASSERT(lnklst_pop_wait_many(list, out, sizeof(int), 4, 10) == 2);
+    ASSERT(out[0] == 2);
+    ASSERT(out[1] == 3);
+    ASSERT(lnklst_count(list) == 0);
+    ASSERT(test_wait_count == 0);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_close(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int value = 1;
+
+    lnklst_push_wait(list, &value, sizeof(int), 0);
+    lnklst_close(list);
+
+    reset_stats();
+    ASSERT(!lnklst_push_wait(list, &value, sizeof(int), 10));
+    ASSERT(lnklst_count(list) == 1);
+
+    // drain, then fail without waiting
+    value = 0;
+    ASSERT(lnklst_pop_wait(list, &value, sizeof(int), -1));
+    ASSERT(value == 1);
+    ASSERT(!lnklst_pop_wait(list, &value, sizeof(int), -1));
+    ASSERT(test_wait_count == 0);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_detach_all(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    struct lnklst_struct *batch;
+
+    // empty
+    batch = lnklst_detach_all(list);
+    ASSERT(batch);
+    ASSERT(lnklst_count(batch) == 0);
+    lnklst_destroy(&batch);
+
+    *(int*)lnklst_allocate(list, sizeof(int)) = 1;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 2;
+    *(int*)lnklst_allocate(list, sizeof(int)) = 3;
+
+    reset_stats();
+    batch = lnklst_detach_all(list);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_allocation_count == 1);
+    ASSERT(lnklst_count(list) == 0);
+    ASSERT(lnklst_first(list) == NULL);
+    ASSERT(lnklst_last(list) == NULL);
+
+    ASSERT(lnklst_count(batch) == 3);
+    ASSERT(*(int*)lnklst_first(batch) == 1);
+    ASSERT(*(int*)lnklst_last(batch) == 3);
+    ASSERT(lnklst_after(batch, lnklst_last(batch)) == NULL);
+    ASSERT(*(int*)lnklst_index(batch,1) == 2);
+
+    // both lists remain usable
+    *(int*)lnklst_allocate(list, sizeof(int)) = 4;
+    *(int*)lnklst_allocate(batch, sizeof(int)) = 5;
+    ASSERT(*(int*)lnklst_first(list) == 4);
+    ASSERT(*(int*)lnklst_before(batch, lnklst_last(batch)) == 3);
+
+    reset_stats();
+    lnklst_destroy(&batch);
+    ASSERT(test_allocation_count == -5);
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_remove_if(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int i;
+
+    ASSERT(lnklst_remove_if(list, is_odd, NULL) == 0);
+
+    for(i=1; i<=7; i++)
+        *(int*)lnklst_allocate(list, sizeof(int)) = i;
+
+    reset_stats();
+    ASSERT(lnklst_remove_if(list, is_odd, NULL) == 4);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_unlock_count == 1);
+    ASSERT(test_allocation_count == -4);
+
+    ASSERT(lnklst_count(list) == 3);
+    ASSERT(*(int*)lnklst_first(list) == 2);
+    ASSERT(*(int*)lnklst_index(list,1) == 4);
+    ASSERT(*(int*)lnklst_last(list) == 6);
+    ASSERT(lnklst_before(list, lnklst_first(list)) == NULL);
+    ASSERT(lnklst_after(list, lnklst_last(list)) == NULL);
+
+    ASSERT(lnklst_remove_if(list, is_odd, NULL) == 0);
+    ASSERT(lnklst_count(list) == 3);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_partition(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    struct lnklst_struct *odd = lnklst_create();
+    struct lnklst_struct *other;
+    int outstanding = 0;
+    const struct lnklst_allocator allocator = {counting_alloc, counting_realloc, counting_free, &outstanding};
+    const void *last;
+    int i;
+
+    *(int*)lnklst_allocate(odd, sizeof(int)) = 0;
+    for(i=1; i<=5; i++)
+        *(int*)lnklst_allocate(list, sizeof(int)) = i;
+
+    reset_stats();
+    ASSERT(lnklst_partition(list, odd, is_odd, NULL) == 3);
+    ASSERT(test_lock_count == 2);
+    ASSERT(test_allocation_count == 0);
+
+    ASSERT(lnklst_count(list) == 2);
+    ASSERT(*(int*)lnklst_first(list) == 2);
+    ASSERT(*(int*)lnklst_last(list) == 4);
+
+    ASSERT(lnklst_count(odd) == 4);
+    ASSERT(*(int*)lnklst_index(odd,0) == 0);
+    ASSERT(*(int*)lnklst_index(odd,1) == 1);
+    ASSERT(*(int*)lnklst_index(odd,2) == 3);
+    ASSERT(*(int*)lnklst_index(odd,3) == 5);
+
+    ASSERT(lnklst_partition(list, list, is_odd, NULL) == 0);
+
+    // the pair is locked in the same order whichever way round they are given
+    lnklst_partition(list, odd, is_odd, NULL);
+    last = test_last_locked;
+    lnklst_partition(odd, list, is_odd, NULL);
+    ASSERT(test_last_locked == last);
+
+    // allocations can't move to a list which would free them with another allocator
+    other = lnklst_create_with_allocator(&allocator);
+    reset_stats();
+    ASSERT(lnklst_partition(odd, other, is_odd, NULL) == 0);
+    ASSERT(test_lock_count == 0);
+    ASSERT(lnklst_count(other) == 0);
+    lnklst_destroy(&other);
+    ASSERT(outstanding == 0);
+
+    lnklst_destroy(&list);
+    lnklst_destroy(&odd);
+    PASS();
+}
+
+TEST test_lnklst_compact(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    struct lnklst_struct *other;
+    void *tracked[2];
+    void *ptr, *next;
+    int i;
+
+    lnklst_compact(list, NULL, NULL);
+
+    // interleave ints with larger zeroed allocations, then punch holes
+    for(i=0; i<10; i++)
+    {
+        *(int*)lnklst_allocate(list, sizeof(int)) = i;
+        memset(lnklst_allocate(list, 100), 0, 100);
+    };
+    lnklst_remove_if(list, is_odd, NULL);
+    lnklst_free(list, lnklst_index(list, 4));
+    lnklst_free(list, lnklst_index(list, 4));
+    ASSERT(lnklst_count(list) == 13);
+
+    tracked[0] = lnklst_index(list, 0);
+    tracked[1] = lnklst_index(list, 12);
+    strcpy(lnklst_index(list, 5), "payload");
+
+    reset_stats();
+    lnklst_compact(list, relocfunc, tracked);
+    ASSERT(test_lock_count == 1);
+    // the 13 allocations now share one block
+    ASSERT(test_allocation_count == 1 - 13);
+
+    ASSERT(lnklst_count(list) == 13);
+    ASSERT(tracked[0] == lnklst_first(list));
+    ASSERT(tracked[1] == lnklst_last(list));
+    ASSERT(!strcmp(lnklst_index(list, 5), "payload"));
+    ASSERT(*(int*)lnklst_index(list, 0) == 0);
+    ASSERT(*(int*)lnklst_index(list, 3) == 2);
+    ASSERT(*(int*)lnklst_index(list, 4) == 4);
+    ASSERT(*(int*)lnklst_index(list, 10) == 8);
+    ASSERT(lnklst_before(list, lnklst_first(list)) == NULL);
+    ASSERT(lnklst_after(list, lnklst_last(list)) == NULL);
+
+    // laid out in list order, each allocation following the one before and its header
+    for(ptr = lnklst_first(list); lnklst_after(list, ptr); ptr = next)
+    {
+        next = lnklst_after(list, ptr);
+        ASSERT((uint8_t*)next > (uint8_t*)ptr);
+        ASSERT((uint8_t*)next - (uint8_t*)ptr <= (ptrdiff_t)(lnklst_header_size + 100 + LNKLST_PLATFORM_ALIGN));
+    };
+    ASSERT((uint8_t*)lnklst_index(list, 1) - (uint8_t*)lnklst_index(list, 0) == (ptrdiff_t)(lnklst_header_size + LNKLST_PLATFORM_ALIGN));
+
+    // the block is only freed with the last allocation in it, wherever that has moved
+    other = lnklst_detach_all(list);
+    lnklst_free(other, lnklst_first(other));
+    reset_stats();
+    while(lnklst_count(other) > 1)
+        lnklst_free(other, lnklst_first(other));
+    ASSERT(test_allocation_count == 0);
+    lnklst_free(other, lnklst_first(other));
+    ASSERT(test_allocation_count == -1);
+
+    // larger than a slab
+    ptr = lnklst_allocate(list, 3 * 1024 * 1024);
+    *(int*)lnklst_allocate(list, sizeof(int)) = 7;
+    memset(ptr, 1, 3 * 1024 * 1024);
+    reset_stats();
+    lnklst_compact(list, NULL, NULL);
+    ASSERT(test_allocation_count == 0);
+    ASSERT(((uint8_t*)lnklst_first(list))[3 * 1024 * 1024 - 1] == 1);
+    ASSERT(*(int*)lnklst_last(list) == 7);
+
+    lnklst_destroy(&other);
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_lru(void)
+{
+    struct lnklst_lru_struct *lru;
+    int entry[2];
+    int key;
+    int i;
+
+    // capacity by count
+    lru_evict_count = 0;
+    lru = lnklst_lru_create(3, 0, lru_keyfunc, lru_hashfunc, lru_keycmp, lru_evictfunc);
+    ASSERT(lru);
+    for(i=1; i<=3; i++)
+    {
+        entry[0] = i;
+        entry[1] = i*10;
+        ASSERT(((int*)lnklst_lru_put(lru, entry, sizeof(entry)))[1] == i*10);
+    };
+    ASSERT(lnklst_lru_count(lru) == 3);
+
+    // touch 1, so 2 becomes the least recently used
+    key = 1;
+    ASSERT(((int*)lnklst_lru_get(lru, &key))[1] == 10);
+    entry[0] = 4;
+    entry[1] = 40;
+    lnklst_lru_put(lru, entry, sizeof(entry));
+    ASSERT(lnklst_lru_count(lru) == 3);
+    ASSERT(lru_evict_count == 1);
+    key = 2;
+    ASSERT(lnklst_lru_get(lru, &key) == NULL);
+    key = 1;
+    ASSERT(lnklst_lru_get(lru, &key) != NULL);
+
+    // replace an existing key
+    entry[0] = 4;
+    entry[1] = 44;
+    lnklst_lru_put(lru, entry, sizeof(entry));
+    ASSERT(lnklst_lru_count(lru) == 3);
+    ASSERT(lru_evict_count == 2);
+    key = 4;
+    ASSERT(((int*)lnklst_lru_get(lru, &key))[1] == 44);
+
+    // explicit eviction
+    key = 3;
+    ASSERT(lnklst_lru_evict(lru, &key));
+    ASSERT(!lnklst_lru_evict(lru, &key));
+    ASSERT(lnklst_lru_count(lru) == 2);
+    ASSERT(lru_evict_count == 3);
+
+    reset_stats();
+    lnklst_lru_destroy(&lru);
+    ASSERT(lru == NULL);
+    ASSERT(lru_evict_count == 5);
+    ASSERT(test_allocation_count == -5);
+
+    // capacity by bytes, with enough entries to re-index
+    lru = lnklst_lru_create(0, 100*sizeof(entry), lru_keyfunc, lru_hashfunc, lru_keycmp, NULL);
+    for(i=0; i<1000; i++)
+    {
+        entry[0] = i;
+        entry[1] = -i;
+        lnklst_lru_put(lru, entry, sizeof(entry));
+    };
+    ASSERT(lnklst_lru_count(lru) == 100);
+    key = 899;
+    ASSERT(lnklst_lru_get(lru, &key) == NULL);
+    for(key=900; key<1000; key++)
+        ASSERT(((int*)lnklst_lru_get(lru, &key))[1] == -key);
+
+    lnklst_lru_destroy(&lru);
+    PASS();
+}
+
+TEST test_lnklst_unrolled(void)
+{
+    struct lnklst_unrolled_struct *list;
+    int *ptr;
+    int i;
+
+    ASSERT(lnklst_create_unrolled(0, 4) == NULL);
+    ASSERT(lnklst_create_unrolled(sizeof(int), 0) == NULL);
+
+    reset_stats();
+    list = lnklst_create_unrolled(sizeof(int), 4);
+    ASSERT(list);
+    ASSERT(lnklst_unrolled_count(list) == 0);
+    ASSERT(lnklst_unrolled_first(list) == NULL);
+    ASSERT(lnklst_unrolled_last(list) == NULL);
+    ASSERT(lnklst_unrolled_index(list, 0) == NULL);
+
+    for(i=0; i<10; i++)
+        *(int*)lnklst_unrolled_allocate(list) = i;
+    ASSERT(lnklst_unrolled_count(list) == 10);
+    // list, blocks list, and 3 blocks
+    ASSERT(test_allocation_count == 5);
+
+    ASSERT(*(int*)lnklst_unrolled_first(list) == 0);
+    ASSERT(*(int*)lnklst_unrolled_last(list) == 9);
+    for(i=0; i<10; i++)
+        ASSERT(*(int*)lnklst_unrolled_index(list, i) == i);
+    for(i=9; i>=0; i--)
+        ASSERT(*(int*)lnklst_unrolled_index(list, i) == i);
+    ASSERT(lnklst_unrolled_index(list, 10) == NULL);
+    ASSERT(lnklst_unrolled_index(list, -1) == NULL);
+
+    // walk both ways across block boundaries
+    i = 0;
+    for(ptr = lnklst_unrolled_first(list); ptr; ptr = lnklst_unrolled_after(list, ptr))
+        ASSERT(*ptr == i++);
+    ASSERT(i == 10);
+    for(ptr = lnklst_unrolled_last(list); ptr; ptr = lnklst_unrolled_before(list, ptr))
+        ASSERT(*ptr == --i);
+    ASSERT(i == 0);
+
+    reset_stats();
+    lnklst_unrolled_destroy(&list);
+    ASSERT(list == NULL);
+    ASSERT(test_allocation_count == -5);
+    PASS();
+}
+
+TEST test_lnklst_unrolled_free(void)
+{
+    struct lnklst_unrolled_struct *list = lnklst_create_unrolled(sizeof(int), 4);
+    int i;
+
+    for(i=0; i<10; i++)
+        *(int*)lnklst_unrolled_allocate(list) = i;
+
+    // from the middle of a block
+    lnklst_unrolled_free(list, lnklst_unrolled_index(list, 5));
+    ASSERT(lnklst_unrolled_count(list) == 9);
+    ASSERT(*(int*)lnklst_unrolled_index(list, 5) == 6);
+    ASSERT(*(int*)lnklst_unrolled_index(list, 8) == 9);
+
+    // empty the last block
+    reset_stats();
+    lnklst_unrolled_free(list, lnklst_unrolled_last(list));
+    lnklst_unrolled_free(list, lnklst_unrolled_last(list));
+    ASSERT(test_allocation_count == -1);
+    ASSERT(*(int*)lnklst_unrolled_last(list) == 7);
+    ASSERT(lnklst_unrolled_after(list, lnklst_unrolled_last(list)) == NULL);
+
+    // empty the first block
+    for(i=0; i<4; i++)
+        lnklst_unrolled_free(list, lnklst_unrolled_first(list));
+    ASSERT(lnklst_unrolled_count(list) == 3);
+    ASSERT(*(int*)lnklst_unrolled_first(list) == 4);
+    ASSERT(lnklst_unrolled_before(list, lnklst_unrolled_first(list)) == NULL);
+
+    // an element not in the list
+    lnklst_unrolled_free(list, &i);
+    ASSERT(lnklst_unrolled_count(list) == 3);
+
+    lnklst_unrolled_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_unrolled_sort(void)
+{
+    struct lnklst_unrolled_struct *list = lnklst_create_unrolled(sizeof(int), 3);
+    struct point *p, *q;
+    int i;
+
+    for(i=0; i<20; i++)
+        *(int*)lnklst_unrolled_allocate(list) = (i * 7) % 20;
+    lnklst_unrolled_free(list, lnklst_unrolled_index(list, 4));
+
+    reset_stats();
+    lnklst_unrolled_sort(list, swapfunc);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_allocation_count == 0);
+
+    ASSERT(lnklst_unrolled_count(list) == 19);
+    for(i=1; i<19; i++)
+        ASSERT(*(int*)lnklst_unrolled_index(list, i-1) < *(int*)lnklst_unrolled_index(list, i));
+    lnklst_unrolled_destroy(&list);
+
+    // equal keys (x, which swapfunc compares) keep the order they were in (y)
+    list = lnklst_create_unrolled(sizeof(struct point), 4);
+    for(i=0; i<30; i++)
+    {
+        p = lnklst_unrolled_allocate(list);
+        p->x = (i * 7) % 5;
+        p->y = i;
+    };
+    lnklst_unrolled_sort(list, swapfunc);
+    for(i=1; i<30; i++)
+    {
+        p = lnklst_unrolled_index(list, i-1);
+        q = lnklst_unrolled_index(list, i);
+        ASSERT(p->x < q->x || (p->x == q->x && p->y < q->y));
+    };
+
+    lnklst_unrolled_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_destroy_async(void)
+{
+    struct lnklst_struct *reclaim = lnklst_create();
+    struct lnklst_struct *list;
+    struct lnklst_arena_struct *arena;
+    int i;
+
+    ASSERT(lnklst_reclaim_step(reclaim, 10) == 0);
+
+    list = lnklst_create();
+    for(i=0; i<10; i++)
+        lnklst_allocate(list, sizeof(int));
+
+    reset_stats();
+    lnklst_destroy_async(&list, reclaim);
+    ASSERT(list == NULL);
+    ASSERT(test_allocation_count == -1);
+    ASSERT(test_destroy_count == 1);
+    ASSERT(lnklst_count(reclaim) == 10);
+
+    // a second list queues up behind the first
+    list = lnklst_create();
+    for(i=0; i<5; i++)
+        *(int*)lnklst_allocate(list, sizeof(int)) = i;
+    lnklst_destroy_async(&list, reclaim);
+    ASSERT(lnklst_count(reclaim) == 15);
+    ASSERT(*(int*)lnklst_last(reclaim) == 4);
+
+    reset_stats();
+    ASSERT(lnklst_reclaim_step(reclaim, 6) == 9);
+    ASSERT(test_allocation_count == -6);
+    ASSERT(test_lock_count == 1);
+    ASSERT(lnklst_reclaim_step(reclaim, 6) == 3);
+    ASSERT(*(int*)lnklst_first(reclaim) == 2);
+    ASSERT(lnklst_reclaim_step(reclaim, 6) == 0);
+    ASSERT(test_allocation_count == -15);
+    ASSERT(lnklst_first(reclaim) == NULL);
+    ASSERT(lnklst_last(reclaim) == NULL);
+
+    #ifdef LNKLST_EPOCH
+    // allocations retired while a reader was inside are moved too
+    list = lnklst_create();
+    lnklst_allocate(list, sizeof(int));
+    lnklst_allocate(list, sizeof(int));
+    i = lnklst_read_enter(list);
+    lnklst_free(list, lnklst_first(list));
+    lnklst_read_exit(list, i);
+    reset_stats();
+    lnklst_destroy_async(&list, reclaim);
+    ASSERT(test_allocation_count == -1);
+    ASSERT(lnklst_count(reclaim) == 2);
+    ASSERT(lnklst_reclaim_step(reclaim, 2) == 0);
+    ASSERT(test_allocation_count == -3);
+    #endif
+
+    // a list from another allocator can't be freed by reclaim, so it is destroyed there and then
+    arena = lnklst_arena_create(4096);
+    list = lnklst_create_with_allocator(lnklst_arena_allocator(arena));
+    for(i=0; i<5; i++)
+        lnklst_allocate(list, sizeof(int));
+    lnklst_destroy_async(&list, reclaim);
+    ASSERT(list == NULL);
+    ASSERT(lnklst_count(reclaim) == 0);
+    ASSERT(lnklst_reclaim_step(reclaim, 10) == 0);
+    lnklst_arena_destroy(&arena);
+
+    lnklst_destroy(&reclaim);
+    PASS();
+}
+
+#ifdef LNKLST_EPOCH
+
+TEST test_lnklst_read(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int *a, *b, *c, *old;
+    int token;
+
+    a = lnklst_allocate(list, sizeof(int));
+    b = lnklst_allocate(list, sizeof(int));
+    c = lnklst_allocate(list, sizeof(int));
+    *a = 1;
+    *b = 2;
+    *c = 3;
+
+    reset_stats();
+    token = lnklst_read_enter(list);
+    ASSERT(lnklst_read_first(list) == a);
+    ASSERT(lnklst_read_after(list, a) == b);
+    ASSERT(lnklst_read_last(list) == c);
+    ASSERT(lnklst_read_before(list, c) == b);
+    ASSERT(lnklst_read_before(list, a) == NULL);
+    ASSERT(lnklst_read_after(list, c) == NULL);
+    ASSERT(test_lock_count == 0);
+
+    // a reader stood on b can still step off it after it is freed
+    lnklst_free(list, b);
+    ASSERT(test_allocation_count == 0);
+    ASSERT(lnklst_count(list) == 2);
+    ASSERT(*b == 2);
+    ASSERT(lnklst_read_after(list, b) == c);
+    ASSERT(lnklst_read_before(list, b) == a);
+    ASSERT(lnklst_read_after(list, a) == c);
+
+    // re-allocation copies, leaving the original, and its links, for the reader
+    old = a;
+    a = lnklst_reallocate(list, a, 64);
+    ASSERT(*a == 1);
+    ASSERT(test_allocation_count == 1);
+    ASSERT(lnklst_read_before(list, old) == NULL);
+    ASSERT(lnklst_read_after(list, old) == c);
+    lnklst_read_exit(list, token);
+
+    // once the reader has left, the next free releases everything
+    lnklst_free(list, c);
+    ASSERT(test_allocation_count == -2);
+    ASSERT(lnklst_read_first(list) == a);
+    ASSERT(lnklst_read_after(list, a) == NULL);
+
+    // with no readers, frees are immediate
+    lnklst_free(list, a);
+    ASSERT(test_allocation_count == -3);
+    ASSERT(lnklst_read_first(list) == NULL);
+    ASSERT(lnklst_read_last(list) == NULL);
+
+    // retired allocations are freed by destroy
+    a = lnklst_allocate(list, sizeof(int));
+    token = lnklst_read_enter(list);
+    lnklst_free(list, a);
+    lnklst_read_exit(list, token);
+    reset_stats();
+    lnklst_destroy(&list);
+    ASSERT(test_allocation_count == -2);
+    PASS();
+}
+
+TEST test_lnklst_snapshot(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    struct lnklst_snapshot_struct *snap;
+    int *ptr;
+    int i;
+
+    for(i = 0; i < 10; i++)
+    {
+        ptr = lnklst_allocate(list, sizeof(int));
+        *ptr = i;
+    };
+
+    reset_stats();
+    snap = lnklst_snapshot(list);
+    ASSERT(test_lock_count == 1);
+    ASSERT(lnklst_snapshot_count(snap) == 10);
+    ASSERT(lnklst_snapshot_index(snap, 10) == NULL);
+    ASSERT(lnklst_snapshot_index(snap, -1) == NULL);
+
+    // change the list under the snapshot
+    lnklst_free(list, lnklst_first(list));
+    lnklst_free(list, lnklst_last(list));
+    ptr = lnklst_index(list, 3);
+    ptr = lnklst_reallocate(list, ptr, 2 * sizeof(int));
+    *ptr = 100;
+    ptr = lnklst_allocate(list, sizeof(int));
+    *ptr = 200;
+    lnklst_sort(list, swapfunc);
+    ASSERT(lnklst_count(list) == 9);
+
+    // the snapshot still sees the list as it was
+    for(i = 0; i < 10; i++)
+        ASSERT(*(int*)lnklst_snapshot_index(snap, i) == i);
+    ASSERT(test_allocation_count == 3);
+
+    // releasing it lets the next change reclaim what it was holding
+    lnklst_snapshot_release(&snap);
+    ASSERT(snap == NULL);
+    ASSERT(test_allocation_count == 2);
+    lnklst_free(list, lnklst_last(list));
+    ASSERT(test_allocation_count == -2);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+#endif
+
+TEST test_lnklst_save_load(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    struct lnklst_struct *loaded;
+    const struct lnklst_map_struct *map;
+    struct stream_struct stream = {NULL, 0, 0};
+    const char *text;
+    uint64_t huge;
+    int *ptr;
+    int i;
+
+    for(i = 0; i < 20; i++)
+    {
+        ptr = lnklst_allocate(list, (i % 5) * sizeof(int));
+        if(i % 5)
+            *ptr = i;
+    };
+
+    ASSERT(lnklst_save(list, true, stream_write, &stream));
+    ASSERT(stream.length % 16 == 8);
+
+    reset_stats();
+    loaded = lnklst_load(stream_read, &stream);
+    ASSERT(loaded != NULL);
+    ASSERT(test_allocation_count == 21);
+    ASSERT(lnklst_count(loaded) == 20);
+    ASSERT(lnklst_count(loaded) == lnklst_count(list));
+    for(i = 0; i < 20; i++)
+    {
+        if(i % 5)
+            ASSERT(*(int*)lnklst_index(loaded, i) == i);
+    };
+    lnklst_destroy(&loaded);
+
+    // walk the image in place
+    map = lnklst_map(stream.data, stream.length);
+    ASSERT(map != NULL);
+    ASSERT(lnklst_map_count(map) == 20);
+    ptr = (int*)lnklst_map_first(map);
+    for(i = 0; i < 20; i++)
+    {
+        ASSERT(ptr != NULL);
+        ASSERT(lnklst_map_size(map, ptr) == (i % 5) * sizeof(int));
+        if(i % 5)
+            ASSERT(*ptr == i);
+        ptr = (int*)lnklst_map_after(map, ptr);
+    };
+    ASSERT(ptr == NULL);
+
+    // corruption is caught by the checksum, and nothing leaks
+    stream.data[100] ^= 1;
+    stream.position = 0;
+    reset_stats();
+    ASSERT(lnklst_load(stream_read, &stream) == NULL);
+    ASSERT(test_allocation_count == 0);
+    ASSERT(lnklst_map(stream.data, stream.length) == NULL);
+
+    // as is truncation, without a checksum
+    free(stream.data);
+    stream.data = NULL;
+    stream.length = 0;
+    stream.position = 0;
+    ASSERT(lnklst_save(list, false, stream_write, &stream));
+    ASSERT(lnklst_map(stream.data, stream.length) != NULL);
+    ASSERT(lnklst_map(stream.data, stream.length - 1) == NULL);
+    stream.length -= 16;
+    reset_stats();
+    ASSERT(lnklst_load(stream_read, &stream) == NULL);
+    ASSERT(test_allocation_count == 0);
+
+    // a truncated image claiming a huge allocation fails without trying to allocate it
+    free(stream.data);
+    stream.data = NULL;
+    stream.length = 0;
+    stream.position = 0;
+    ASSERT(lnklst_save(list, false, stream_write, &stream));
+    // the image header's byte count is at 16, and the first record's size at 32
+    huge = ((uint64_t)1 << 46) + 16;
+    memcpy(stream.data + 16, &huge, sizeof(huge));
+    huge -= 16;
+    memcpy(stream.data + 32, &huge, sizeof(huge));
+    reset_stats();
+    ASSERT(lnklst_load(stream_read, &stream) == NULL);
+    ASSERT(test_allocation_count == 0);
+
+    // a payload larger than one read round trips
+    lnklst_destroy(&list);
+    list = lnklst_create();
+    ptr = lnklst_allocate(list, 100000 * sizeof(int));
+    for(i = 0; i < 100000; i++)
+        ptr[i] = i;
+    free(stream.data);
+    stream.data = NULL;
+    stream.length = 0;
+    stream.position = 0;
+    ASSERT(lnklst_save(list, true, stream_write, &stream));
+    loaded = lnklst_load(stream_read, &stream);
+    ASSERT(loaded != NULL);
+    ptr = lnklst_first(loaded);
+    ASSERT(memcmp(ptr, lnklst_first(list), 100000 * sizeof(int)) == 0);
+    lnklst_destroy(&loaded);
+
+    // an empty list
+    lnklst_destroy(&list);
+    list = lnklst_create();
+    free(stream.data);
+    stream.data = NULL;
+    stream.length = 0;
+    stream.position = 0;
+    ASSERT(lnklst_save(list, true, stream_write, &stream));
+    map = lnklst_map(stream.data, stream.length);
+    ASSERT(lnklst_map_count(map) == 0);
+    ASSERT(lnklst_map_first(map) == NULL);
+    loaded = lnklst_load(stream_read, &stream);
+    ASSERT(lnklst_count(loaded) == 0);
+    lnklst_destroy(&loaded);
+
+    text = "not a list";
+    ASSERT(lnklst_map(text, strlen(text)) == NULL);
+
+    free(stream.data);
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_shm(void)
+{
+    static uint64_t region[64] __attribute__((aligned(16)));
+    struct lnklst_shm_struct *shm;
+    void *a, *b, *c;
+    int value = 0;
+
+    ASSERT(lnklst_shm_create(region, 32) == NULL);
+    ASSERT(lnklst_shm_attach(region) == NULL);
+    reset_stats();
+    shm = lnklst_shm_create(region, sizeof(region));
+    ASSERT(shm != NULL);
+    ASSERT(lnklst_shm_attach(region) == shm);
+    ASSERT(test_allocation_count == 0);
+
+    a = lnklst_shm_allocate(shm, 40);
+    b = lnklst_shm_allocate(shm, 1);
+    c = lnklst_shm_allocate(shm, 16);
+    ASSERT(a != NULL && b != NULL && c != NULL);
+    ASSERT(((uintptr_t)a & 15) == 0);
+    ASSERT(((uintptr_t)b & 15) == 0);
+    ASSERT(test_allocation_count == 0);
+    ASSERT(lnklst_shm_count(shm) == 3);
+    ASSERT(lnklst_shm_first(shm) == a);
+    ASSERT(lnklst_shm_last(shm) == c);
+    ASSERT(lnklst_shm_after(shm, a) == b);
+    ASSERT(lnklst_shm_before(shm, c) == b);
+    ASSERT(lnklst_shm_before(shm, a) == NULL);
+    ASSERT(lnklst_shm_after(shm, c) == NULL);
+
+    // the region fills up
+    ASSERT(lnklst_shm_allocate(shm, sizeof(region)) == NULL);
+
+    // freed blocks merge, so the whole region is available again
+    lnklst_shm_free(shm, b);
+    ASSERT(lnklst_shm_after(shm, a) == c);
+    lnklst_shm_free(shm, a);
+    lnklst_shm_free(shm, c);
+    ASSERT(lnklst_shm_count(shm) == 0);
+    ASSERT(lnklst_shm_first(shm) == NULL);
+    a = lnklst_shm_allocate(shm, sizeof(region) - 96);
+    ASSERT(a != NULL);
+    ASSERT(lnklst_shm_allocate(shm, 1) == NULL);
+    lnklst_shm_free(shm, a);
+
+    value = 7;
+    ASSERT(lnklst_shm_push_back(shm, &value, sizeof(value)) != NULL);
+    value = 0;
+    ASSERT(lnklst_shm_pop_front(shm, &value, sizeof(value)));
+    ASSERT(value == 7);
+    ASSERT(!lnklst_shm_pop_front(shm, &value, sizeof(value)));
+
+    lnklst_shm_destroy(shm);
+    ASSERT(lnklst_shm_attach(region) == NULL);
+    PASS();
+}
+
+TEST test_lnklst_shm_fork(void)
+{
+    size_t size = 4096;
+    struct lnklst_shm_struct *shm;
+    void *region;
+    pid_t pid;
+    int status;
+    int sum = 0;
+    int i;
+
+    region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT(region != MAP_FAILED);
+    shm = lnklst_shm_create(region, size);
+    for(i = 1; i <= 10; i++)
+        ASSERT(lnklst_shm_push_back(shm, &i, sizeof(i)) != NULL);
+
+    // the child consumes the list, and answers in the same list
+    pid = fork();
+    ASSERT(pid >= 0);
+    if(pid == 0)
+    {
+        shm = lnklst_shm_attach(region);
+        while(lnklst_shm_pop_front(shm, &i, sizeof(i)))
+            sum += i;
+        lnklst_shm_push_back(shm, &sum, sizeof(sum));
+        _exit(0);
+    };
+    ASSERT(waitpid(pid, &status, 0) == pid);
+    ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    ASSERT(lnklst_shm_count(shm) == 1);
+    ASSERT(*(int*)lnklst_shm_first(shm) == 55);
+    lnklst_shm_destroy(shm);
+    munmap(region, size);
+    PASS();
+}
+
+TEST test_lnklst_allocator(void)
+{
+    int outstanding = 0;
+    const struct lnklst_allocator allocator = {counting_alloc, counting_realloc, counting_free, &outstanding};
+    struct lnklst_struct *list;
+    struct lnklst_struct *detached;
+    int *ptr;
+    int i;
+
+    reset_stats();
+    list = lnklst_create_with_allocator(&allocator);
+    ASSERT(list != NULL);
+    ASSERT(outstanding == 1);
+    for(i = 0; i < 5; i++)
+    {
+        ptr = lnklst_allocate(list, sizeof(int));
+        *ptr = i;
+    };
+    ASSERT(lnklst_push_back(list, &i, sizeof(i)) != NULL);
+    ASSERT(outstanding == 7);
+
+    ptr = lnklst_reallocate(list, lnklst_first(list), 100);
+    ASSERT(*ptr == 0);
+    lnklst_free(list, lnklst_last(list));
+    ASSERT(lnklst_pop_front(list, NULL, 0));
+    ASSERT(outstanding == 5);
+
+    // a detached list inherits the allocator
+    detached = lnklst_detach_all(list);
+    ASSERT(outstanding == 6);
+    ASSERT(lnklst_count(detached) == 4);
+    lnklst_destroy(&detached);
+    ASSERT(outstanding == 1);
+
+    // nothing went through the platform allocator
+    ASSERT(test_allocation_count == 0);
+    lnklst_destroy(&list);
+    ASSERT(outstanding == 0);
+    PASS();
+}
+
+TEST test_lnklst_reorder(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    void *order[5];
+    int *ptr;
+    int i;
+
+    for(i = 0; i < 5; i++)
+    {
+        ptr = lnklst_allocate(list, sizeof(int));
+        *ptr = i;
+        order[4 - i] = ptr;
+    };
+
+    // the wrong count is ignored
+    lnklst_reorder(list, order, 4);
+    ASSERT(*(int*)lnklst_first(list) == 0);
+
+    lnklst_reorder(list, order, 5);
+    for(i = 0; i < 5; i++)
+        ASSERT(*(int*)lnklst_index(list, i) == 4 - i);
+    ASSERT(*(int*)lnklst_first(list) == 4);
+    ASSERT(*(int*)lnklst_last(list) == 0);
+    ASSERT(lnklst_before(list, lnklst_first(list)) == NULL);
+    ASSERT(lnklst_after(list, lnklst_last(list)) == NULL);
+    ASSERT(*(int*)lnklst_before(list, lnklst_last(list)) == 1);
+    ASSERT(lnklst_count(list) == 5);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_typed(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    struct point point;
+    void *all[40];
+    int i;
+
+    for(i = 0; i < 37; i++)
+        ASSERT(points_push_back(list, (struct point){(i * 7) % 37, i}) != NULL);
+    points_push_front(list, (struct point){5, -1});
+    ASSERT(points_count(list) == 38);
+    ASSERT(points_first(list)->y == -1);
+    ASSERT(lnklst_gather(list, all, 40) == 38);
+    ASSERT(lnklst_gather(list, all, 3) == 3);
+    ASSERT(all[2] == points_index(list, 2));
+
+    // gathered, sorted and re-linked under one lock
+    reset_stats();
+    points_sort(list);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_allocation_count == 0);
+    for(i = 0; i < 37; i++)
+        ASSERT(points_index(list, i)->x <= points_index(list, i + 1)->x);
+    // equal keys keep their order
+    ASSERT(points_index(list, 5)->y == -1);
+    ASSERT(points_index(list, 6)->x == 5);
+    ASSERT(points_after(list, points_index(list, 5)) == points_index(list, 6));
+    ASSERT(points_before(list, points_first(list)) == NULL);
+
+    ASSERT(points_pop_front(list, &point));
+    ASSERT(point.x == 0 && point.y == 0);
+    ASSERT(points_pop_back(list, &point));
+    ASSERT(point.x == 36);
+    ASSERT(points_last(list)->x == 35);
+
+    // an odd number of passes, which ends in the scratch array
+    lnklst_destroy(&list);
+    list = lnklst_create();
+    for(i = 0; i < 5; i++)
+        points_push_back(list, (struct point){4 - i, i});
+    points_sort(list);
+    for(i = 0; i < 5; i++)
+        ASSERT(points_index(list, i)->x == i);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_allocate_aligned(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int outstanding = 0;
+    const struct lnklst_allocator skewed = {skewed_alloc, skewed_realloc, skewed_free, &outstanding};
+    size_t alignment;
+    uint8_t *ptr;
+    int i;
+
+    ASSERT(lnklst_allocate_aligned(list, 8, 0) == NULL);
+    ASSERT(lnklst_allocate_aligned(list, 8, 48) == NULL);
+    ASSERT(lnklst_allocate_aligned(list, 8, 2 * LNKLST_MAX_ALIGNMENT) == NULL);
+
+    reset_stats();
+    for(alignment = 1; alignment <= LNKLST_MAX_ALIGNMENT; alignment *= 2)
+    {
+        ptr = lnklst_allocate_aligned(list, 100, alignment);
+        ASSERT(((uintptr_t)ptr & (alignment - 1)) == 0);
+        memset(ptr, (int)alignment, 100);
+        lnklst_allocate(list, 1);
+    };
+    ASSERT(lnklst_count(list) == 26);
+    ASSERT(test_allocation_count == 26);
+
+    // re-allocation keeps the alignment, and the contents
+    ptr = lnklst_index(list, 24);
+    ptr = lnklst_reallocate(list, ptr, 5000);
+    ASSERT(((uintptr_t)ptr & (LNKLST_MAX_ALIGNMENT - 1)) == 0);
+    ASSERT(ptr[99] == 0);
+    ASSERT(lnklst_index(list, 24) == ptr);
+    ptr = lnklst_reallocate(list, lnklst_index(list, 12), 10);
+    ASSERT(((uintptr_t)ptr & 63) == 0);
+    ASSERT(ptr[9] == 64);
+
+    // as does compaction, into a single slab
+    lnklst_compact(list, NULL, NULL);
+    for(i = 0, alignment = 1; i < 26; i += 2, alignment *= 2)
+        ASSERT(((uintptr_t)lnklst_index(list, i) & (alignment - 1)) == 0);
+    ASSERT(test_allocation_count == 1);
+    ASSERT(*(uint8_t*)lnklst_index(list, 24) == 0);
+    ptr = lnklst_index(list, 12);
+    ASSERT(ptr[9] == 64);
+
+    // and re-allocating from a slab copies out of it
+    ptr = lnklst_reallocate(list, ptr, 20);
+    ASSERT(((uintptr_t)ptr & 63) == 0);
+    ASSERT(ptr[9] == 64);
+    ASSERT(test_allocation_count == 2);
+
+    lnklst_free(list, lnklst_index(list, 22));
+    ASSERT(test_allocation_count == 2);
+    lnklst_destroy(&list);
+
+    // blocks only aligned as far as LNKLST_PLATFORM_ALIGN promises still give aligned allocations, which stay within them
+    list = lnklst_create_with_allocator(&skewed);
+    for(alignment = 1; alignment <= LNKLST_MAX_ALIGNMENT; alignment *= 2)
+    {
+        ptr = lnklst_allocate_aligned(list, 100, alignment);
+        ASSERT(((uintptr_t)ptr & (alignment - 1)) == 0);
+        memset(ptr, (int)alignment, 100);
+        ptr = lnklst_allocate(list, 100);
+        ASSERT(((uintptr_t)ptr & (LNKLST_PLATFORM_ALIGN - 1)) == 0);
+        memset(ptr, 0, 100);
+        ptr = lnklst_reallocate(list, ptr, 200);
+        memset(ptr, 0, 200);
+    };
+    lnklst_compact(list, NULL, NULL);
+    for(i = 0, alignment = 1; i < 26; i += 2, alignment *= 2)
+        ASSERT(((uintptr_t)lnklst_index(list, i) & (alignment - 1)) == 0);
+    lnklst_destroy(&list);
+    ASSERT(outstanding == 0);
+    ASSERT(skewed_overruns == 0);
+    PASS();
+}
+
+TEST test_lnklst_arena(void)
+{
+    struct lnklst_arena_struct *arena = lnklst_arena_create(4096);
+    struct lnklst_struct *list;
+    uint8_t *big;
+    int *ptr;
+    int i;
+
+    reset_stats();
+    list = lnklst_create_with_allocator(lnklst_arena_allocator(arena));
+    ASSERT_CHUNKS(test_allocation_count == 1);
+
+    // many small allocations share a few chunks
+    for(i = 0; i < 1000; i++)
+    {
+        ptr = lnklst_allocate(list, sizeof(int));
+        *ptr = i;
+    };
+    ASSERT_CHUNKS(test_allocation_count > 10);
+    ASSERT_CHUNKS(test_allocation_count < 30);
+    for(i = 0; i < 1000; i++)
+        ASSERT(*(int*)lnklst_index(list, i) == i);
+
+    // one larger than a chunk gets its own
+    big = lnklst_allocate(list, 10000);
+    memset(big, 1, 10000);
+    big = lnklst_reallocate(list, big, 20000);
+    ASSERT(big[9999] == 1);
+    ptr = lnklst_reallocate(list, lnklst_index(list, 1), sizeof(int));
+    ASSERT(*ptr == 1);
+
+    // chunks are returned as they empty, leaving the one holding the list, and the one allocated from
+    while(lnklst_count(list))
+        lnklst_free(list, lnklst_first(list));
+    ASSERT_CHUNKS(test_allocation_count == 2);
+    ASSERT(lnklst_allocate(list, sizeof(int)) != NULL);
+    ASSERT_CHUNKS(test_allocation_count == 2);
+
+    lnklst_destroy(&list);
+    lnklst_arena_destroy(&arena);
+    ASSERT(arena == NULL);
+    ASSERT(test_allocation_count == -1);
+
+    // a chunk size too small for anything is raised to fit at least one allocation, one too large to round is refused
+    ASSERT(lnklst_arena_create(SIZE_MAX) == NULL);
+    for(i = 0; i < 3; i++)
+    {
+        arena = lnklst_arena_create(i * 8);
+        list = lnklst_create_with_allocator(lnklst_arena_allocator(arena));
+        ptr = lnklst_allocate(list, sizeof(int));
+        *ptr = i;
+        big = lnklst_allocate(list, 300);
+        memset(big, i, 300);
+        ASSERT(*(int*)lnklst_first(list) == i);
+        ASSERT(((uint8_t*)lnklst_last(list))[299] == i);
+        lnklst_destroy(&list);
+        lnklst_arena_destroy(&arena);
+    };
+    PASS();
+}
+
+TEST test_lnklst_parallel(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    long identity = 0;
+    long sum;
+    int *ptr;
+    int i;
+
+    // an empty list
+    lnklst_parallel_reduce(list, sum_map, sum_combine, &identity, &sum, sizeof(sum), 4);
+    ASSERT(sum == 0);
+
+    for(i = 1; i <= 1000; i++)
+    {
+        ptr = lnklst_allocate(list, sizeof(int));
+        *ptr = i;
+    };
+
+    // the calling thread runs the last segment
+    test_thread_count = 0;
+    reset_stats();
+    lnklst_parallel_reduce(list, sum_map, sum_combine, &identity, &sum, sizeof(sum), 7);
+    ASSERT(sum == 500500);
+    ASSERT(test_thread_count == 6);
+    ASSERT(test_lock_count == 1);
+    ASSERT(test_allocation_count == 0);
+
+    lnklst_parallel_foreach(list, add_to, &i, 3);
+    lnklst_parallel_reduce(list, sum_map, sum_combine, &identity, &sum, sizeof(sum), 1);
+    ASSERT(sum == 500500 + 1001 * 1000);
+    ASSERT(*(int*)lnklst_first(list) == 1002);
+    ASSERT(*(int*)lnklst_last(list) == 2001);
+
+    // no more segments than allocations
+    lnklst_destroy(&list);
+    list = lnklst_create();
+    ptr = lnklst_allocate(list, sizeof(int));
+    *ptr = 5;
+    test_thread_count = 0;
+    lnklst_parallel_foreach(list, add_to, &i, 8);
+    ASSERT(test_thread_count == 0);
+    ASSERT(*ptr == 1006);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_pool(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    struct lnklst_pool_struct *pool;
+    long identity = 0;
+    long sum;
+    int one = 1;
+    int *ptr;
+    int i;
+
+    test_thread_count = 0;
+    pool = lnklst_pool_create(3);
+    ASSERT(test_thread_count == 3);
+
+    lnklst_pool_reduce(pool, list, sum_map, sum_combine, &identity, &sum, sizeof(sum));
+    ASSERT(sum == 0);
+
+    for(i = 1; i <= 1000; i++)
+    {
+        ptr = lnklst_allocate(list, sizeof(int));
+        *ptr = i;
+    };
+
+    // the test threads don't run until joined, so the calling thread steals every segment
+    reset_stats();
+    lnklst_pool_reduce(pool, list, sum_map, sum_combine, &identity, &sum, sizeof(sum));
+    ASSERT(sum == 500500);
+    ASSERT(test_wait_count == 0);
+    ASSERT(test_broadcast_count == 1);
+    ASSERT(test_allocation_count == 0);
+    ASSERT(test_thread_count == 3);
+
+    lnklst_pool_foreach(pool, list, add_to, &one);
+    lnklst_pool_reduce(pool, list, sum_map, sum_combine, &identity, &sum, sizeof(sum));
+    ASSERT(sum == 501500);
+    ASSERT(*(int*)lnklst_first(list) == 2);
+    ASSERT(*(int*)lnklst_last(list) == 1001);
+
+    // joining the workers once stopped returns straight away
+    reset_stats();
+    lnklst_pool_destroy(&pool);
+    ASSERT(pool == NULL);
+    ASSERT(test_allocation_count == -1);
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_find(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    struct session
+    {
+        int hits;
+        char name[32];
+    } *s;
+    void *matches[4];
+    int limit = 50;
+    char key[32];
+    int i;
+
+    ASSERT(lnklst_find(list, less_than, &limit) == NULL);
+    ASSERT(lnklst_find_bytes(list, 0, "", 0) == NULL);
+    ASSERT(lnklst_find_all(list, less_than, &limit, matches, 4) == 0);
+
+    for(i = 0; i < 100; i++)
+    {
+        s = lnklst_allocate(list, sizeof(struct session));
+        s->hits = 100 - i;
+        memset(s->name, 0, sizeof(s->name));
+        snprintf(s->name, sizeof(s->name), "session-%03d-with-a-long-name", i);
+    };
+    // too short to hold a name, so never matched by lnklst_find_bytes()
+    s = lnklst_allocate(list, sizeof(int));
+    *(int*)s = 1000;
+
+    s = lnklst_find(list, less_than, &limit);
+    ASSERT(s == lnklst_index(list, 51));
+    ASSERT(s->hits == 49);
+    limit = -1;
+    ASSERT(lnklst_find(list, less_than, &limit) == NULL);
+
+    // 28 bytes exercises the vector, word and byte comparisons
+    memset(key, 0, sizeof(key));
+    snprintf(key, sizeof(key), "session-%03d-with-a-long-name", 42);
+    s = lnklst_find_bytes(list, offsetof(struct session, name), key, strlen(key));
+    ASSERT(s == lnklst_index(list, 42));
+    key[strlen(key) - 1] = 'x';
+    ASSERT(lnklst_find_bytes(list, offsetof(struct session, name), key, strlen(key)) == NULL);
+    ASSERT(lnklst_find_bytes(list, offsetof(struct session, name), "session-099", 11) == lnklst_index(list, 99));
+    i = 58;
+    ASSERT(lnklst_find_bytes(list, 0, &i, sizeof(int)) == lnklst_index(list, 42));
+    i = 1000;
+    ASSERT(lnklst_find_bytes(list, 0, &i, sizeof(int)) == lnklst_last(list));
+    ASSERT(lnklst_find_bytes(list, sizeof(int), &i, sizeof(int)) == NULL);
+    // an offset so large that adding the key's length would wrap is past the end of every allocation
+    ASSERT(lnklst_find_bytes(list, SIZE_MAX, &i, 2) == NULL);
+    ASSERT(lnklst_find_bytes(list, 0, &i, SIZE_MAX) == NULL);
+
+    limit = 6;
+    ASSERT(lnklst_find_all(list, less_than, &limit, matches, 4) == 5);
+    ASSERT(matches[0] == lnklst_index(list, 95));
+    ASSERT(matches[3] == lnklst_index(list, 98));
+    ASSERT(lnklst_find_all(list, less_than, &limit, NULL, 0) == 5);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_merge_sorted(void)
+{
+    struct lnklst_struct *lists[4];
+    struct lnklst_struct *dst = lnklst_create();
+    struct lnklst_struct *src = lnklst_create();
+    struct lnklst_struct *other;
+    int outstanding = 0;
+    const struct lnklst_allocator allocator = {counting_alloc, counting_realloc, counting_free, &outstanding};
+    const void *locked;
+    struct record
+    {
+        int key;
+        int from;
+    } *r, *prev;
+    int i, j;
+
+    // merging an empty list changes nothing
+    lnklst_merge_sorted(dst, src, swapfunc);
+    ASSERT(lnklst_count(dst) == 0);
+
+    for(i = 0; i < 10; i++)
+    {
+        r = lnklst_allocate(dst, sizeof(struct record));
+        r->key = i * 2;
+        r->from = 0;
+        r = lnklst_allocate(src, sizeof(struct record));
+        r->key = i * 3;
+        r->from = 1;
+    };
+
+    reset_stats();
+    lnklst_merge_sorted(dst, src, swapfunc);
+    ASSERT(test_allocation_count == 0);
+    ASSERT(lnklst_count(src) == 0);
+    ASSERT(lnklst_first(src) == NULL);
+    ASSERT(lnklst_count(dst) == 20);
+    prev = NULL;
+    for(r = lnklst_first(dst), i = 0; r; r = lnklst_after(dst, r), i++)
+    {
+        // ties keep those already in dst first
+        if(prev)
+            ASSERT(prev->key < r->key || (prev->key == r->key && prev->from < r->from));
+        prev = r;
+    };
+    ASSERT(i == 20);
+    ASSERT(((struct record*)lnklst_last(dst))->key == 27);
+    ASSERT(lnklst_before(dst, lnklst_first(dst)) == NULL);
+    ASSERT(((struct record*)lnklst_index(dst, 19))->key == 27);
+
+    // into an empty list
+    lnklst_merge_sorted(src, dst, swapfunc);
+    ASSERT(lnklst_count(src) == 20);
+    ASSERT(lnklst_count(dst) == 0);
+
+    lists[0] = src;
+    for(j = 1; j < 4; j++)
+    {
+        lists[j] = lnklst_create();
+        for(i = 0; i < 5 * j; i++)
+        {
+            r = lnklst_allocate(lists[j], sizeof(struct record));
+            r->key = i * (j + 1);
+            r->from = j + 2;
+        };
+    };
+
+    lnklst_merge_sorted_many(dst, lists, 4, swapfunc);
+    ASSERT(lnklst_count(dst) == 20 + 5 + 10 + 15);
+    for(j = 0; j < 4; j++)
+        ASSERT(lnklst_count(lists[j]) == 0);
+    prev = NULL;
+    for(r = lnklst_first(dst), i = 0; r; r = lnklst_after(dst, r), i++)
+    {
+        if(prev)
+            ASSERT(prev->key < r->key || (prev->key == r->key && prev->from <= r->from));
+        prev = r;
+    };
+    ASSERT(i == 50);
+    ASSERT(((struct record*)lnklst_last(dst))->key == 56);
+
+    // dst's own allocations take part, and come first on ties
+    r = lnklst_allocate(lists[1], sizeof(struct record));
+    r->key = 0;
+    r->from = 9;
+    lnklst_merge_sorted_many(dst, lists, 4, swapfunc);
+    ASSERT(lnklst_count(dst) == 51);
+    ASSERT(((struct record*)lnklst_index(dst, 4))->key == 0);
+    ASSERT(((struct record*)lnklst_index(dst, 5))->from == 9);
+    ASSERT(((struct record*)lnklst_index(dst, 6))->key != 0);
+
+    // dst, repeats and NULLs in srcs are skipped, and each list is locked once
+    r = lnklst_allocate(lists[2], sizeof(struct record));
+    r->key = 1;
+    r->from = 9;
+    lnklst_destroy(&lists[1]);
+    lnklst_destroy(&lists[3]);
+    lists[0] = dst;
+    lists[1] = lists[2];
+    lists[3] = NULL;
+    reset_stats();
+    lnklst_merge_sorted_many(dst, lists, 4, swapfunc);
+    ASSERT(test_lock_count == 2);
+    ASSERT(test_unlock_count == 2);
+    ASSERT(lnklst_count(dst) == 52);
+    ASSERT(lnklst_count(lists[2]) == 0);
+
+    // lists are locked in the same order whichever way round they are given
+    lnklst_merge_sorted(dst, src, swapfunc);
+    locked = test_last_locked;
+    lnklst_merge_sorted(src, dst, swapfunc);
+    ASSERT(test_last_locked == locked);
+    lnklst_merge_sorted(dst, src, swapfunc);
+
+    // nor are allocations moved to a list which would free them with another allocator
+    other = lnklst_create_with_allocator(&allocator);
+    r = lnklst_allocate(other, sizeof(struct record));
+    r->key = 0;
+    lists[3] = other;
+    reset_stats();
+    lnklst_merge_sorted(dst, other, swapfunc);
+    ASSERT(test_lock_count == 0);
+    lnklst_merge_sorted_many(dst, lists, 4, swapfunc);
+    ASSERT(test_lock_count == 2);
+    ASSERT(lnklst_count(other) == 1);
+    ASSERT(lnklst_count(dst) == 52);
+    lnklst_destroy(&other);
+    ASSERT(outstanding == 0);
+
+    lists[0] = src;
+    lists[1] = lnklst_create();
+    lists[3] = lnklst_create();
+    for(j = 1; j < 4; j++)
+        lnklst_destroy(&lists[j]);
+    lnklst_destroy(&src);
+    lnklst_destroy(&dst);
+    PASS();
+}
+
+TEST test_lnklst_top_k(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    struct record
+    {
+        int key;
+        int seq;
+    } *r;
+    void *top[10];
+    int i;
+
+    ASSERT(lnklst_top_k(list, 10, swapfunc, top) == 0);
+    lnklst_partial_sort(list, 10, swapfunc);
+
+    for(i = 0; i < 1000; i++)
+    {
+        r = lnklst_allocate(list, sizeof(struct record));
+        r->key = (i * 7919) % 500;
+        r->seq = i;
+    };
+
+    // each key appears twice, the earlier first
+    ASSERT(lnklst_top_k(list, 5, swapfunc, top) == 5);
+    for(i = 0; i < 5; i++)
+    {
+        ASSERT(((struct record*)top[i])->key == i / 2);
+        if(i & 1)
+            ASSERT(((struct record*)top[i])->seq > ((struct record*)top[i - 1])->seq);
+    };
+    ASSERT(lnklst_count(list) == 1000);
+    ASSERT(((struct record*)lnklst_first(list))->seq == 0);
+
+    reset_stats();
+    lnklst_partial_sort(list, 10, swapfunc);
+    ASSERT(test_allocation_count == 0);
+    ASSERT(lnklst_count(list) == 1000);
+    for(i = 0; i < 10; i++)
+        ASSERT(((struct record*)lnklst_index(list, i))->key == i / 2);
+    ASSERT(lnklst_index(list, 0) == top[0]);
+    ASSERT(lnklst_before(list, lnklst_first(list)) == NULL);
+    // the rest keep their order
+    ASSERT(((struct record*)lnklst_index(list, 10))->seq == 1);
+    ASSERT(((struct record*)lnklst_index(list, 11))->seq == 2);
+    ASSERT(((struct record*)lnklst_last(list))->seq == 999);
+    for(i = 0, r = lnklst_last(list); r; r = lnklst_before(list, r))
+        i++;
+    ASSERT(i == 1000);
+
+    // more than the list holds sorts the whole list
+    ASSERT(lnklst_top_k(list, 2000, swapfunc, NULL) == 0);
+    lnklst_partial_sort(list, 2000, swapfunc);
+    ASSERT(((struct record*)lnklst_last(list))->key == 499);
+    ASSERT(((struct record*)lnklst_index(list, 500))->key == 250);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_sort_incremental(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    struct lnklst_struct *other;
+    struct record
+    {
+        int key;
+        int seq;
+    } *r, *prev;
+    int i;
+
+    for(i = 0; i < 1000; i++)
+    {
+        r = lnklst_allocate(list, sizeof(struct record));
+        r->key = (i * 7919) % 1000;
+        r->seq = i;
+    };
+    swapfunc_calls = 0;
+    lnklst_sort(list, counted_swapfunc);
+    ASSERT(swapfunc_calls > 5000);
+
+    // already sorted
+    swapfunc_calls = 0;
+    lnklst_sort(list, counted_swapfunc);
+    ASSERT(swapfunc_calls == 0);
+
+    // a batch at the back is sorted on its own, then merged in
+    for(i = 0; i < 10; i++)
+    {
+        r = lnklst_allocate(list, sizeof(struct record));
+        r->key = 995 - i * 100;
+        r->seq = 1000 + i;
+    };
+    // freeing from the sorted part leaves it sorted
+    lnklst_free(list, lnklst_index(list, 500));
+    swapfunc_calls = 0;
+    lnklst_sort(list, counted_swapfunc);
+    // against over 5000 for the whole list
+    ASSERT(swapfunc_calls < 1100);
+    ASSERT(lnklst_count(list) == 1009);
+    prev = NULL;
+    for(r = lnklst_first(list), i = 0; r; r = lnklst_after(list, r), i++)
+    {
+        // ties keep the earlier first
+        if(prev)
+            ASSERT(prev->key < r->key || (prev->key == r->key && prev->seq < r->seq));
+        prev = r;
+    };
+    ASSERT(i == 1009);
+    ASSERT(((struct record*)lnklst_last(list))->key == 999);
+    ASSERT(lnklst_before(list, lnklst_first(list)) == NULL);
+
+    // a different swapfunc sorts it all
+    swapfunc_calls = 0;
+    lnklst_sort(list, swapfunc);
+    lnklst_sort(list, counted_swapfunc);
+    ASSERT(swapfunc_calls > 5000);
+
+    // as does anything put in front
+    r = lnklst_push_front(list, NULL, sizeof(struct record));
+    r->key = 2000;
+    r->seq = -1;
+    swapfunc_calls = 0;
+    lnklst_sort(list, counted_swapfunc);
+    ASSERT(swapfunc_calls > 1000);
+    ASSERT(lnklst_last(list) == r);
+
+    // or being told
+    r->key = -1;
+    lnklst_mark_unsorted(list);
+    lnklst_sort(list, counted_swapfunc);
+    ASSERT(lnklst_first(list) == r);
+
+    // detaching keeps what is known
+    other = lnklst_detach_all(list);
+    r = lnklst_allocate(other, sizeof(struct record));
+    r->key = 0;
+    r->seq = 2000;
+    swapfunc_calls = 0;
+    lnklst_sort(other, counted_swapfunc);
+    ASSERT(swapfunc_calls < 100);
+    ASSERT(lnklst_index(other, 2) == r);
+
+    lnklst_destroy(&other);
+
+    // partial sorts count too
+    for(i = 0; i < 100; i++)
+    {
+        r = lnklst_allocate(list, sizeof(struct record));
+        r->key = 100 - i;
+        r->seq = i;
+    };
+    lnklst_partial_sort(list, 50, counted_swapfunc);
+    swapfunc_calls = 0;
+    lnklst_sort(list, counted_swapfunc);
+    ASSERT(swapfunc_calls < 300);
+    for(i = 0; i < 100; i++)
+        ASSERT(((struct record*)lnklst_index(list, i))->key == i + 1);
+
+    lnklst_destroy(&list);
+    PASS();
+}
+
+TEST test_lnklst_queue_wake(void)
+{
+    struct lnklst_struct *list = lnklst_create();
+    int values[2];
+    int value;
+
+    // a push while a consumer waits wakes it
+    test_wait_hook = push_one;
+    test_wait_ctx = list;
+    test_wait_hooks = 1;
+    test_clock = 0;
+    ASSERT(lnklst_pop_wait(list, &value, sizeof(int), 1000));
+    ASSERT(value == 42);
+    ASSERT(test_clock == 500);
+
+    // woken for pushes which other consumers take, the timeout still runs from the start of the call
+    test_wait_hook = push_and_take;
+    test_wait_hooks = 3;
+    test_clock = 0;
+    ASSERT(!lnklst_pop_wait(list, &value, sizeof(int), 1000));
+    ASSERT(test_clock == 1000);
+    ASSERT(lnklst_count(list) == 0);
+
+    // a pop while a producer waits for room wakes it
+    lnklst_set_capacity(list, 1);
+    ASSERT(lnklst_push_wait(list, &value, sizeof(int), 0));
+    test_wait_hook = take_one;
+    test_wait_hooks = 1;
+    test_clock = 0;
+    value = 7;
+    ASSERT(lnklst_push_wait(list, &value, sizeof(int), 1000));
+    ASSERT(test_clock == 500);
+    ASSERT(*(int*)lnklst_first(list) == 7);
+
+    // room made as the wait times out is still used, before giving up on the rest of the batch
+    test_wait_hooks = 1;
+    test_late_wakes = 1;
+    values[0] = 8;
+    values[1] = 9;
+    ASSERT(lnklst_push_wait_many(list, values, sizeof(int), 2, 1000) == 1);
+    ASSERT(*(int*)lnklst_first(list) == 8);
+    ASSERT(test_late_wakes == 0);
+
+    test_wait_hook = NULL;
+    lnklst_destroy(&list);
+    PASS();
+}
+
+static void reset_stats(void)
+{
+    test_lock_count = 0;
+    test_unlock_count = 0;
+    test_init_count = 0;
+    test_destroy_count = 0;
+    test_allocation_count = 0;
+    test_wait_count = 0;
+    test_signal_count = 0;
+    test_broadcast_count = 0;
+}
+
+static int swapfunc(void *a, void *b)
+{
+    return *(int*)a - *(int*)b;
+}
+
+
+static bool is_odd(void *allocation, void *ctx)
+{
+    (void)ctx;
+    return *(int*)allocation & 1;
+}
+
+static bool less_than(void *allocation, void *ctx)
+{
+    return *(int*)allocation < *(int*)ctx;
+}
+
+static int counted_swapfunc(void *a, void *b)
+{
+    swapfunc_calls++;
+    return *(int*)a - *(int*)b;
+}
+
+static void push_one(void *ctx)
+{
+    int value = 42;
+    lnklst_push_back(ctx, &value, sizeof(int));
+}
+
+static void push_and_take(void *ctx)
+{
+    push_one(ctx);
+    lnklst_pop_front(ctx, NULL, 0);
+}
+
+static void take_one(void *ctx)
+{
+    lnklst_free(ctx, lnklst_first(ctx));
+}
+
+static void relocfunc(void *old, void *new, void *ctx)
+{
+    void **tracked = ctx;
+    int i;
+    for(i=0; i<2; i++)
+    {
+        if(tracked[i] == old)
+            tracked[i] = new;
+    };
+}
+
+static void* lru_keyfunc(void *entry)
+{
+    return entry;
+}
+
+static uint32_t lru_hashfunc(void *key)
+{
+    return *(uint32_t*)key * 2654435761u;
+}
+
+static int lru_keycmp(void *a, void *b)
+{
+    return *(int*)a - *(int*)b;
+}
+
+static void lru_evictfunc(void *entry)
+{
+    (void)entry;
+    lru_evict_count++;
+}
+
+
+static bool stream_write(const void *src, size_t len, void *ctx)
+{
+    struct stream_struct *stream = ctx;
+    stream->data = realloc(stream->data, stream->length + len);
+    memcpy(stream->data + stream->length, src, len);
+    stream->length += len;
+    return true;
+}
+
+static bool stream_read(void *dst, size_t len, void *ctx)
+{
+    struct stream_struct *stream = ctx;
+    bool retval = false;
+    if(len <= stream->length - stream->position)
+    {
+        memcpy(dst, stream->data + stream->position, len);
+        stream->position += len;
+        retval = true;
+    };
+    return retval;
+}
+
+
+static void* counting_alloc(size_t size, void *ctx)
+{
+    (*(int*)ctx)++;
+    return malloc(size);
+}
+
+static void* counting_realloc(void *ptr, size_t size, void *ctx)
+{
+    (void)ctx;
+    return realloc(ptr, size);
+}
+
+static void counting_free(void *ptr, void *ctx)
+{
+    (*(int*)ctx)--;
+    free(ptr);
+}
+
+//blocks aligned to LNKLST_PLATFORM_ALIGN but never to anything larger, with a guard after them to catch writes past the end
+static void* skewed_alloc(size_t size, void *ctx)
+{
+    uint8_t *block = malloc(sizeof(struct skewed_prefix) + size + 2 * LNKLST_MAX_ALIGNMENT + SKEW_GUARD);
+    uint8_t *page = (uint8_t*)(((uintptr_t)block + sizeof(struct skewed_prefix) + LNKLST_MAX_ALIGNMENT - 1) & ~(uintptr_t)(LNKLST_MAX_ALIGNMENT - 1));
+    struct skewed_prefix *prefix = (struct skewed_prefix*)page - 1;
+    uint8_t *retval = page + LNKLST_PLATFORM_ALIGN;
+
+    prefix->block = block;
+    prefix->size = size;
+    memset(retval + size, 0xA5, SKEW_GUARD);
+    (*(int*)ctx)++;
+    return retval;
+}
+
+static void* skewed_realloc(void *ptr, size_t size, void *ctx)
+{
+    struct skewed_prefix *prefix = (struct skewed_prefix*)((uint8_t*)ptr - LNKLST_PLATFORM_ALIGN) - 1;
+    void *retval = skewed_alloc(size, ctx);
+
+    memcpy(retval, ptr, size < prefix->size ? size : prefix->size);
+    skewed_free(ptr, ctx);
+    return retval;
+}
+
+static void skewed_free(void *ptr, void *ctx)
+{
+    struct skewed_prefix *prefix = (struct skewed_prefix*)((uint8_t*)ptr - LNKLST_PLATFORM_ALIGN) - 1;
+    uint8_t *guard = (uint8_t*)ptr + prefix->size;
+    int i;
+
+    for(i = 0; i < SKEW_GUARD; i++)
+    {
+        if(guard[i] != 0xA5)
+        {
+            skewed_overruns++;
+            break;
+        };
+    };
+    (*(int*)ctx)--;
+    free(prefix->block);
+}
+
+
+static void add_to(void *allocation, void *ctx)
+{
+    *(int*)allocation += *(int*)ctx;
+}
+
+static void sum_map(void *acc, void *allocation)
+{
+    *(long*)acc += *(int*)allocation;
+}
+
+static void sum_combine(void *acc, void *other)
+{
+    *(long*)acc += *(long*)other;
+}
@@ -0,0 +1,355 @@
+	#include <iterator>
+    #include <stdexcept>
+    #include <string>
+    #include <utility>
+
+    #include "greatest.h"
+    #include "../lnklst.hpp"
+
+//********************************************************************************************************
+// Local defines
+//********************************************************************************************************
+
+	GREATEST_MAIN_DEFS();
+
+    extern "C"
+    {
+        extern int test_lock_count;
+        extern int test_allocation_count;
+        extern int test_failing_allocations;
+    }
+
+    //counts its live instances, so the tests can see every element constructed is destroyed exactly once
+    struct counted
+    {
+        static int live;
+        std::string name;
+        int key;
+
+        counted(std::string name, int key) : name(std::move(name)), key(key) { live++; }
+        counted(const counted &other) : name(other.name), key(other.key) { live++; }
+        counted(counted &&other) : name(std::move(other.name)), key(other.key) { live++; }
+        ~counted() { live--; }
+    };
+
+    int counted::live = 0;
+
+    //throws from its constructor when asked to
+    struct fragile
+    {
+        explicit fragile(bool fail) { if(fail) throw std::runtime_error("fragile"); }
+    };
+
+//********************************************************************************************************
+// Private prototypes
+//********************************************************************************************************
+
+	SUITE(suite_all_tests);
+
+    TEST test_hpp_lifetimes(void);
+    TEST test_hpp_constructor_throws(void);
+    TEST test_hpp_out_of_memory(void);
+    TEST test_hpp_iteration(void);
+    TEST test_hpp_erase(void);
+    TEST test_hpp_move(void);
+    TEST test_hpp_sort(void);
+    TEST test_hpp_layout(void);
+
+//********************************************************************************************************
+// Public functions
+//********************************************************************************************************
+
+int main(int argc, const char* argv[])
+{
+	GREATEST_MAIN_BEGIN();
+	RUN_SUITE(suite_all_tests);
+	GREATEST_MAIN_END();
+
+	return 0;
+}
+
+//********************************************************************************************************
+// Private functions
+//********************************************************************************************************
+
+SUITE(suite_all_tests)
+{
+    RUN_TEST(test_hpp_lifetimes);
+    RUN_TEST(test_hpp_constructor_throws);
+    RUN_TEST(test_hpp_out_of_memory);
+    RUN_TEST(test_hpp_iteration);
+    RUN_TEST(test_hpp_erase);
+    RUN_TEST(test_hpp_move);
+    RUN_TEST(test_hpp_sort);
+    RUN_TEST(test_hpp_layout);
+}
+
+TEST test_hpp_lifetimes(void)
+{
+    counted value("copied", 1);
+
+    test_allocation_count = 0;
+    counted::live = 1;
+    {
+        lnklst::list<counted> list;
+        ASSERT(list.empty());
+        ASSERT(test_allocation_count == 1);
+
+        list.emplace_back("back", 2);
+        list.emplace_front("front", 0);
+        list.push_back(value);
+        list.push_back(counted("moved", 3));
+        ASSERT(counted::live == 5);
+        ASSERT(list.size() == 4);
+        ASSERT(test_allocation_count == 5);
+        ASSERT(list.front().name == "front");
+        ASSERT(list.back().name == "moved");
+
+        list.pop_front();
+        list.pop_back();
+        ASSERT(counted::live == 3);
+        ASSERT(list.front().name == "back");
+        ASSERT(list.back().name == "copied");
+
+        list.clear();
+        ASSERT(list.empty());
+        ASSERT(counted::live == 1);
+
+        // destroying the list destroys what is left in it
+        list.emplace_back("left", 4);
+        list.emplace_back("behind", 5);
+        ASSERT(counted::live == 3);
+    }
+    ASSERT(counted::live == 1);
+    ASSERT(test_allocation_count == 0);
+    PASS();
+}
+
+TEST test_hpp_constructor_throws(void)
+{
+    lnklst::list<fragile> list;
+    bool thrown = false;
+
+    list.emplace_back(false);
+    test_allocation_count = 0;
+    try
+    {
+        list.emplace_back(true);
+    }
+    catch(const std::runtime_error&)
+    {
+        thrown = true;
+    };
+    ASSERT(thrown);
+    // the allocation made for it is freed again
+    ASSERT(list.size() == 1);
+    ASSERT(test_allocation_count == 0);
+    PASS();
+}
+
+TEST test_hpp_out_of_memory(void)
+{
+    lnklst::list<counted> list;
+    int thrown = 0;
+
+    // a failed allocation throws rather than constructing into NULL
+    counted::live = 0;
+    list.emplace_back("kept", 1);
+    test_failing_allocations = 1;
+    try
+    {
+        list.emplace_back("lost", 2);
+    }
+    catch(const std::bad_alloc&)
+    {
+        thrown++;
+    };
+    test_failing_allocations = 1;
+    try
+    {
+        list.emplace_front("lost", 0);
+    }
+    catch(const std::bad_alloc&)
+    {
+        thrown++;
+    };
+    ASSERT(thrown == 2);
+    ASSERT(list.size() == 1);
+    ASSERT(counted::live == 1);
+
+    // as does the list itself
+    test_failing_allocations = 1;
+    try
+    {
+        lnklst::list<int> empty;
+    }
+    catch(const std::bad_alloc&)
+    {
+        thrown++;
+    };
+    ASSERT(thrown == 3);
+    ASSERT(test_failing_allocations == 0);
+    PASS();
+}
+
+TEST test_hpp_iteration(void)
+{
+    lnklst::list<int> list;
+    const lnklst::list<int> &view = list;
+    lnklst::list<int>::iterator it;
+    lnklst::list<int>::const_iterator cit;
+    int i;
+
+    ASSERT(list.begin() == list.end());
+    ASSERT(view.cbegin() == view.cend());
+
+    for(i = 0; i < 10; i++)
+        list.push_back(i);
+
+    i = 0;
+    for(int &x : list)
+        ASSERT(x == i++);
+    ASSERT(i == 10);
+    ASSERT(std::distance(view.begin(), view.end()) == 10);
+
+    // backwards from the end
+    it = list.end();
+    for(i = 9; i >= 0; i--)
+        ASSERT(*--it == i);
+    ASSERT(it == list.begin());
+
+    // writes through an iterator, read back through a const_iterator converted from it
+    for(it = list.begin(); it != list.end(); it++)
+        *it *= 2;
+    cit = list.begin();
+    cit++;
+    ASSERT(*cit == 2);
+    ASSERT(*std::prev(view.end()) == 18);
+    PASS();
+}
+
+TEST test_hpp_erase(void)
+{
+    lnklst::list<counted> list;
+    lnklst::list<counted>::iterator it;
+    int i;
+
+    counted::live = 0;
+    for(i = 0; i < 6; i++)
+        list.emplace_back(std::to_string(i), i);
+
+    // erase returns the element after the one erased
+    it = list.erase(std::next(list.begin(), 2));
+    ASSERT(it->key == 3);
+    ASSERT(list.size() == 5);
+    ASSERT(counted::live == 5);
+
+    // erasing every other element while walking
+    it = list.begin();
+    while(it != list.end())
+    {
+        it = list.erase(it);
+        if(it != list.end())
+            it++;
+    };
+    ASSERT(list.size() == 2);
+    ASSERT(list.front().key == 1);
+    ASSERT(list.back().key == 4);
+
+    // the last element, leaving the end
+    it = list.erase(std::prev(list.end()));
+    ASSERT(it == list.end());
+    ASSERT(list.erase(list.begin()) == list.end());
+    ASSERT(list.empty());
+    ASSERT(counted::live == 0);
+    PASS();
+}
+
+TEST test_hpp_move(void)
+{
+    lnklst::list<counted> a;
+    lnklst::list<counted> c;
+
+    counted::live = 0;
+    a.emplace_back("a", 1);
+    a.emplace_back("b", 2);
+
+    // the elements move with the list, rather than being copied
+    lnklst::list<counted> b(std::move(a));
+    ASSERT(counted::live == 2);
+    ASSERT(b.size() == 2);
+    ASSERT(b.front().name == "a");
+
+    // assignment destroys what was there
+    c.emplace_back("c", 3);
+    c = std::move(b);
+    ASSERT(counted::live == 2);
+    ASSERT(c.size() == 2);
+    ASSERT(c.back().name == "b");
+
+    // moving to itself keeps the elements
+    lnklst::list<counted> &same = c;
+    c = std::move(same);
+    ASSERT(c.size() == 2);
+    ASSERT(counted::live == 2);
+    PASS();
+}
+
+TEST test_hpp_sort(void)
+{
+    lnklst::list<counted> list;
+    lnklst::list<int> ints;
+    const counted *prev = nullptr;
+    int i;
+
+    ints.sort();
+    ASSERT(ints.empty());
+    for(i = 0; i < 50; i++)
+        ints.push_back((i * 17) % 50);
+    ints.sort();
+    i = 0;
+    for(int x : ints)
+        ASSERT(x == i++);
+
+    for(i = 0; i < 40; i++)
+        list.emplace_back(std::to_string(i), (i * 7) % 5);
+
+    // re-linked under one lock, and stable
+    test_lock_count = 0;
+    list.sort([](const counted &a, const counted &b) { return a.key < b.key; });
+    ASSERT(test_lock_count == 1);
+    ASSERT(list.size() == 40);
+    for(const counted &x : list)
+    {
+        if(prev)
+            ASSERT(prev->key < x.key || (prev->key == x.key && std::stoi(prev->name) < std::stoi(x.name)));
+        prev = &x;
+    };
+
+    // and walks backwards in the same order
+    ASSERT(list.back().key == 4);
+    ASSERT(std::prev(list.end(), 8)->key == 4);
+    ASSERT(std::prev(list.end(), 9)->key == 3);
+    PASS();
+}
+
+TEST test_hpp_layout(void)
+{
+    lnklst::list<double> list;
+    struct lnklst_struct *native = list.native_handle();
+
+    // the wrapper's view of the links must agree with the C API
+    ASSERT(lnklst_first(native) == NULL);
+    list.push_back(1.0);
+    list.push_back(2.0);
+    lnklst_push_front(native, NULL, sizeof(double));
+    *(double*)lnklst_first(native) = 0.5;
+
+    ASSERT(&list.front() == lnklst_first(native));
+    ASSERT(&list.back() == lnklst_last(native));
+    ASSERT(&*std::next(list.begin()) == lnklst_index(native, 1));
+    ASSERT(list.front() == 0.5);
+    ASSERT(list.size() == 3);
+    ASSERT(lnklst_header_size % LNKLST_PLATFORM_ALIGN == 0);
+    PASS();
+}